@@ -0,0 +1,484 @@
+#include "Types.h"
+#include "Utilities.h"
+#include "FArc.h"
+#include "FArcBuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace FArcBenchmark
+{
+	using FArcExtractor::FArcSignature;
+	using PeepoHappy::Compression::Method;
+
+	enum class EntrySizeDistribution
+	{
+		// NOTE: Thousands of entries of up to a few KB, dominated by per entry overhead
+		ManySmall,
+		// NOTE: Hundreds of entries spread log-uniformly from a few bytes up to a MB
+		Mixed,
+		// NOTE: A handful of multi MB entries, dominated by raw throughput
+		FewLarge,
+	};
+
+	struct SyntheticFArcSettings
+	{
+		FArcSignature Signature;
+		bool Encrypted;
+		Method CompressionMethod;
+		bool SplitChunks;
+		EntrySizeDistribution SizeDistribution;
+		u64 Seed;
+	};
+
+	struct BenchmarkCase
+	{
+		std::string_view Name;
+		SyntheticFArcSettings Settings;
+	};
+
+	constexpr BenchmarkCase BenchmarkCases[] =
+	{
+		{ "FArC_plain_gzip_mixed", { FArcSignature::FArC, false, Method::GZip, false, EntrySizeDistribution::Mixed, 0x1001 } },
+		{ "FArC_plain_gzip_large", { FArcSignature::FArC, false, Method::GZip, false, EntrySizeDistribution::FewLarge, 0x1002 } },
+		{ "FArC_plain_stored_small", { FArcSignature::FArC, false, Method::None, false, EntrySizeDistribution::ManySmall, 0x1003 } },
+		{ "FARC_encrypted_gzip_small", { FArcSignature::FARC, true, Method::GZip, false, EntrySizeDistribution::ManySmall, 0x2001 } },
+		{ "FARC_encrypted_gzip_mixed", { FArcSignature::FARC, true, Method::GZip, false, EntrySizeDistribution::Mixed, 0x2002 } },
+		{ "FARC_encrypted_stored_large", { FArcSignature::FARC, true, Method::None, false, EntrySizeDistribution::FewLarge, 0x2003 } },
+		{ "FARc_plain_zstd_mixed", { FArcSignature::FARc, false, Method::ZStd, false, EntrySizeDistribution::Mixed, 0x3001 } },
+		{ "FARc_plain_zstd_split_large", { FArcSignature::FARc, false, Method::ZStd, true, EntrySizeDistribution::FewLarge, 0x3002 } },
+		{ "FARc_encrypted_zstd_small", { FArcSignature::FARc, true, Method::ZStd, false, EntrySizeDistribution::ManySmall, 0x3003 } },
+		{ "FARc_encrypted_zstd_split_mixed", { FArcSignature::FARc, true, Method::ZStd, true, EntrySizeDistribution::Mixed, 0x3004 } },
+		{ "FARc_encrypted_zstd_large", { FArcSignature::FARc, true, Method::ZStd, false, EntrySizeDistribution::FewLarge, 0x3005 } },
+	};
+
+	// NOTE: xorshift64* so the generated archives are identical across runs, compilers and platforms
+	class RandomGenerator
+	{
+	public:
+		explicit RandomGenerator(u64 seed) : state((seed != 0) ? seed : 0x9E3779B97F4A7C15ull) {}
+
+	public:
+		u64 Next()
+		{
+			state ^= (state >> 12);
+			state ^= (state << 25);
+			state ^= (state >> 27);
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		f64 NextUnit() { return static_cast<f64>(Next() >> 11) * (1.0 / 9007199254740992.0); }
+		size_t NextInRange(size_t min, size_t max) { return min + static_cast<size_t>(Next() % (max - min + 1)); }
+
+	private:
+		u64 state;
+	};
+
+	constexpr size_t SplitChunkSize = (256 * 1024);
+	constexpr u32 SyntheticFArcAlignment = 16;
+
+	std::vector<size_t> GenerateEntrySizes(EntrySizeDistribution distribution, u32 scaleDivisor, RandomGenerator& random)
+	{
+		size_t entryCount, minSize, maxSize;
+		bool logUniform = true;
+
+		switch (distribution)
+		{
+		case EntrySizeDistribution::ManySmall: entryCount = 4096; minSize = 16; maxSize = (16 * 1024); break;
+		case EntrySizeDistribution::Mixed: entryCount = 512; minSize = 16; maxSize = (1024 * 1024); break;
+		case EntrySizeDistribution::FewLarge: entryCount = 16; minSize = (4 * 1024 * 1024); maxSize = (16 * 1024 * 1024); logUniform = false; break;
+		default: assert(false); return {};
+		}
+
+		entryCount = std::max<size_t>(entryCount / scaleDivisor, 1);
+		maxSize = std::max(maxSize / scaleDivisor, minSize);
+		minSize = std::min(minSize, maxSize);
+
+		std::vector<size_t> entrySizes(entryCount);
+		for (auto& entrySize : entrySizes)
+		{
+			if (logUniform)
+				entrySize = static_cast<size_t>(std::exp(std::log(static_cast<f64>(minSize)) + (std::log(static_cast<f64>(maxSize)) - std::log(static_cast<f64>(minSize))) * random.NextUnit()));
+			else
+				entrySize = random.NextInRange(minSize, maxSize);
+		}
+
+		// NOTE: Real archives always contain a few empty and tiny files
+		if (entryCount >= 4)
+		{
+			entrySizes[random.NextInRange(0, entryCount - 1)] = 0;
+			entrySizes[random.NextInRange(0, entryCount - 1)] = 1;
+		}
+
+		return entrySizes;
+	}
+
+	// NOTE: Alternates between short random literals drawn from a small alphabet and copies of recently generated data,
+	//		 ending up roughly as compressible as typical game assets
+	void GenerateEntryContent(u8* outData, size_t dataSize, RandomGenerator& random)
+	{
+		constexpr size_t maxMatchDistance = (4 * 1024);
+
+		size_t position = 0;
+		while (position < dataSize)
+		{
+			const u64 value = random.Next();
+			const size_t runSize = std::min<size_t>(8 + (value & 31), dataSize - position);
+
+			if (position >= maxMatchDistance && (value & 0x100) != 0)
+			{
+				const size_t matchDistance = 1 + ((value >> 16) % maxMatchDistance);
+				for (size_t i = 0; i < runSize; i++, position++)
+					outData[position] = outData[position - matchDistance];
+			}
+			else
+			{
+				for (size_t i = 0; i < runSize; i++, position++)
+					outData[position] = static_cast<u8>(0x40 + (random.Next() & 15));
+			}
+		}
+	}
+
+	// NOTE: Entry contents are generated on the compression threads, each from its own seed derived from the archive seed and entry index
+	//		 and with a fixed IV, so the output is byte for byte identical no matter how many threads are used
+	bool WriteSyntheticFArc(std::string_view filePath, const SyntheticFArcSettings& settings, u32 scaleDivisor, u32 jobCount)
+	{
+		RandomGenerator random(settings.Seed);
+		const auto entrySizes = GenerateEntrySizes(settings.SizeDistribution, scaleDivisor, random);
+
+		FArcExtractor::FArcBuildSettings buildSettings = {};
+		buildSettings.Signature = settings.Signature;
+		buildSettings.CompressionMethod = settings.CompressionMethod;
+		buildSettings.SplitChunkSize = settings.SplitChunks ? SplitChunkSize : 0;
+		buildSettings.Encrypted = settings.Encrypted;
+		buildSettings.Alignment = SyntheticFArcAlignment;
+		buildSettings.JobCount = jobCount;
+
+		PeepoHappy::Crypto::Aes128IVBytes iv = {};
+		for (auto& ivByte : iv)
+			ivByte = static_cast<u8>(random.Next());
+		buildSettings.IV = iv;
+
+		FArcExtractor::FArcBuilder builder(buildSettings);
+		for (size_t entryIndex = 0; entryIndex < entrySizes.size(); entryIndex++)
+		{
+			char nameBuffer[32];
+			snprintf(nameBuffer, sizeof(nameBuffer), "synthetic_%05zu.bin", entryIndex);
+
+			builder.AddSource(nameBuffer, entrySizes[entryIndex], [&settings, entryIndex, entrySize = entrySizes[entryIndex]](std::vector<u8>& outContent)
+			{
+				RandomGenerator entryRandom(settings.Seed ^ ((entryIndex + 1) * 0x9E3779B97F4A7C15ull));
+				outContent.resize(entrySize);
+				GenerateEntryContent(outContent.data(), outContent.size(), entryRandom);
+				return true;
+			});
+		}
+
+		return builder.Build(filePath);
+	}
+
+	enum class ResultFormat
+	{
+		Text,
+		Csv,
+	};
+
+	struct BenchmarkOptions
+	{
+		u32 JobCount = PeepoHappy::Threading::GetHardwareThreadCount();
+		u32 IterationCount = 5;
+		std::string_view DataDirectory = "farc_bench_data";
+		std::vector<std::string_view> CasePatterns;
+		ResultFormat Format = ResultFormat::Text;
+		bool Quick = false;
+		bool GenerateOnly = false;
+	};
+
+	struct StageResult
+	{
+		std::string_view CaseName;
+		std::string_view StageName;
+		size_t EntryCount;
+		u64 ByteCount;
+		f64 BestSeconds;
+	};
+
+	// NOTE: Runs the setup outside of the timed region before every iteration and keeps the fastest run,
+	//		 which is the least affected by whatever else the machine happens to be doing at the time
+	template <typename SetupFunc, typename RunFunc>
+	f64 MeasureBestSeconds(u32 iterationCount, SetupFunc setup, RunFunc run, bool& outWasSuccessful)
+	{
+		f64 bestSeconds = std::numeric_limits<f64>::max();
+		outWasSuccessful = true;
+
+		for (u32 iteration = 0; iteration < std::max(iterationCount, 1u); iteration++)
+		{
+			setup();
+
+			const auto startTime = std::chrono::steady_clock::now();
+			outWasSuccessful &= run();
+			const auto endTime = std::chrono::steady_clock::now();
+
+			bestSeconds = std::min(bestSeconds, std::chrono::duration<f64>(endTime - startTime).count());
+		}
+
+		return bestSeconds;
+	}
+
+	bool RunBenchmarkCase(const BenchmarkCase& benchmarkCase, std::string_view farcPath, const BenchmarkOptions& options, PeepoHappy::Threading::ThreadPool& threadPool, std::vector<StageResult>& outResults)
+	{
+		using FArcExtractor::FArcDecryptMode;
+		bool wasSuccessful = true, allSuccessful = true;
+
+		auto farc = FArcExtractor::OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy);
+		if (!farc.File.IsOpen() || farc.Signature == FArcSignature::Invalid)
+			return false;
+
+		const size_t entryCount = farc.Entries.size();
+		u64 totalUncompressedSize = 0;
+		for (const auto& entry : farc.Entries)
+			totalUncompressedSize += entry.UncompressedSize;
+
+		// NOTE: Lazily decrypted archives only ever decrypt their entry table, making this the parse cost alone
+		const f64 parseSeconds = MeasureBestSeconds(options.IterationCount, [&] { farc = {}; }, [&]
+		{
+			farc = FArcExtractor::OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy);
+			return (farc.Entries.size() == entryCount);
+		}, wasSuccessful);
+		outResults.push_back({ benchmarkCase.Name, "parse", entryCount, farc.EntryTableSize, parseSeconds });
+		allSuccessful &= wasSuccessful;
+
+		const size_t encryptedPayloadSize = farc.File.Size() - FArcExtractor::FArcEncryptedDataOffset;
+		if (benchmarkCase.Settings.Encrypted)
+		{
+			const f64 decryptSeconds = MeasureBestSeconds(options.IterationCount, [&] { farc = {}; }, [&]
+			{
+				farc = FArcExtractor::OpenReadDecryptAndParseFArcEntries(farcPath, &threadPool, FArcDecryptMode::Eager);
+				return (farc.Entries.size() == entryCount);
+			}, wasSuccessful);
+			outResults.push_back({ benchmarkCase.Name, "decrypt", entryCount, encryptedPayloadSize, decryptSeconds });
+			allSuccessful &= wasSuccessful;
+		}
+
+		// NOTE: Decrypted up front so both of the following stages only measure themselves
+		farc = FArcExtractor::OpenReadDecryptAndParseFArcEntries(farcPath, &threadPool, FArcDecryptMode::Eager);
+
+		auto releaseDecompressedEntries = [&] { for (auto& entry : farc.Entries) entry.DecompressedFileContent.reset(); };
+		auto decompressAllEntries = [&] { return FArcExtractor::ReadAndDecompressAllFArcEntries(farc, threadPool); };
+
+		const f64 decompressSeconds = MeasureBestSeconds(options.IterationCount, releaseDecompressedEntries, decompressAllEntries, wasSuccessful);
+		outResults.push_back({ benchmarkCase.Name, "decompress", entryCount, totalUncompressedSize, decompressSeconds });
+		allSuccessful &= wasSuccessful;
+
+		const std::string outputDirectory = std::string(PeepoHappy::Path::TrimFileExtension(farcPath));
+		const f64 writeSeconds = MeasureBestSeconds(options.IterationCount, [&] { releaseDecompressedEntries(); decompressAllEntries(); }, [&]
+		{
+			return FArcExtractor::ExtractWriteAllFArcEntriesIntoDirectory(farc, outputDirectory, &threadPool);
+		}, wasSuccessful);
+		outResults.push_back({ benchmarkCase.Name, "write", entryCount, totalUncompressedSize, writeSeconds });
+		allSuccessful &= wasSuccessful;
+
+		return allSuccessful;
+	}
+
+	void PrintResults(const std::vector<StageResult>& results, ResultFormat format)
+	{
+		constexpr f64 bytesPerMegabyte = (1024.0 * 1024.0);
+
+		if (format == ResultFormat::Csv)
+			printf("case,stage,entries,bytes,best_ms,mb_per_second,entries_per_second\n");
+		else
+			printf("%-34s %-10s %8s %10s %10s %10s %12s\n", "Case", "Stage", "Entries", "MB", "Best ms", "MB/s", "Entries/s");
+
+		for (const auto& result : results)
+		{
+			const f64 megabytesPerSecond = (result.BestSeconds > 0.0) ? (static_cast<f64>(result.ByteCount) / bytesPerMegabyte / result.BestSeconds) : 0.0;
+			const f64 entriesPerSecond = (result.BestSeconds > 0.0) ? (static_cast<f64>(result.EntryCount) / result.BestSeconds) : 0.0;
+
+			if (format == ResultFormat::Csv)
+			{
+				printf("%.*s,%.*s,%zu,%llu,%.3f,%.2f,%.0f\n", static_cast<int>(result.CaseName.size()), result.CaseName.data(), static_cast<int>(result.StageName.size()), result.StageName.data(),
+					result.EntryCount, static_cast<unsigned long long>(result.ByteCount), result.BestSeconds * 1000.0, megabytesPerSecond, entriesPerSecond);
+			}
+			else
+			{
+				printf("%-34.*s %-10.*s %8zu %10.2f %10.3f %10.2f %12.0f\n", static_cast<int>(result.CaseName.size()), result.CaseName.data(), static_cast<int>(result.StageName.size()), result.StageName.data(),
+					result.EntryCount, static_cast<f64>(result.ByteCount) / bytesPerMegabyte, result.BestSeconds * 1000.0, megabytesPerSecond, entriesPerSecond);
+			}
+		}
+	}
+
+	bool ParseBenchmarkOptions(int argc, const char** argv, BenchmarkOptions& outOptions)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const auto argument = std::string_view(argv[i]);
+			std::string_view value;
+
+			auto readOptionValue = [&]() -> bool
+			{
+				if (i + 1 >= argc)
+				{
+					fprintf(stderr, "[ERROR] Missing value for '%s'\n", argv[i]);
+					return false;
+				}
+
+				value = std::string_view(argv[++i]);
+				return true;
+			};
+
+			auto readCountValue = [&](u32& outCount) -> bool
+			{
+				if (!readOptionValue())
+					return false;
+
+				if (auto[end, error] = std::from_chars(value.data(), value.data() + value.size(), outCount); error != std::errc() || end != value.data() + value.size())
+				{
+					fprintf(stderr, "[ERROR] Invalid count '%s'\n", argv[i]);
+					return false;
+				}
+				return true;
+			};
+
+			if (PeepoHappy::ASCII::Matches(argument, "--jobs") || PeepoHappy::ASCII::Matches(argument, "-j"))
+			{
+				if (!readCountValue(outOptions.JobCount))
+					return false;
+
+				if (outOptions.JobCount == 0)
+					outOptions.JobCount = PeepoHappy::Threading::GetHardwareThreadCount();
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--iterations"))
+			{
+				if (!readCountValue(outOptions.IterationCount))
+					return false;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--directory"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				outOptions.DataDirectory = value;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--case"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				outOptions.CasePatterns.push_back(value);
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--format"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				if (PeepoHappy::ASCII::MatchesInsensitive(value, "text"))
+					outOptions.Format = ResultFormat::Text;
+				else if (PeepoHappy::ASCII::MatchesInsensitive(value, "csv"))
+					outOptions.Format = ResultFormat::Csv;
+				else
+				{
+					fprintf(stderr, "[ERROR] Unknown result format '%s'\n", argv[i]);
+					return false;
+				}
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--quick"))
+			{
+				outOptions.Quick = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--generate-only"))
+			{
+				outOptions.GenerateOnly = true;
+			}
+			else
+			{
+				fprintf(stderr, "[ERROR] Unknown option '%s'\n", argv[i]);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	int EntryPoint()
+	{
+		const auto[argc, argv] = PeepoHappy::UTF8::GetCommandLineArguments();
+
+		BenchmarkOptions options = {};
+		if (!ParseBenchmarkOptions(argc, argv, options))
+		{
+			printf("Description:\n");
+			printf("    Measures the parse, decrypt, decompress and write throughput of the FArc extractor\n");
+			printf("    on deterministically generated synthetic archives\n");
+			printf("\n");
+			printf("Usage:\n");
+			printf("    farc_bench.exe [options]\n");
+			printf("\n");
+			printf("Options:\n");
+			printf("    -j, --jobs {count}      Number of worker threads (0 = one per hardware thread, default)\n");
+			printf("    --iterations {count}    Number of timed runs per stage of which the fastest is reported (default 5)\n");
+			printf("    --directory {path}      Directory the synthetic archives are generated into and extracted within (default \"farc_bench_data\")\n");
+			printf("    --case {glob}           Only run cases matching the case insensitive {glob} pattern, may be repeated\n");
+			printf("    --format {format}       Result format, either text (default) or csv\n");
+			printf("    --quick                 Generate archives with an eighth of the entries of at most an eighth of the size\n");
+			printf("    --generate-only         Only generate the synthetic archives without running any of the benchmarks\n");
+			printf("\n");
+			printf("Notes:\n");
+			printf("    Archives are only generated if they don't exist yet, delete the data directory after changing the generator.\n");
+			printf("\n");
+			return EXIT_WIDEPEEPOSAD;
+		}
+
+		constexpr u32 quickScaleDivisor = 8;
+		const u32 scaleDivisor = options.Quick ? quickScaleDivisor : 1;
+
+		PeepoHappy::IO::CreateFileDirectory(options.DataDirectory);
+		PeepoHappy::Threading::ThreadPool threadPool(options.JobCount);
+
+		std::vector<StageResult> results;
+		size_t failedCaseCount = 0;
+
+		for (const auto& benchmarkCase : BenchmarkCases)
+		{
+			if (!options.CasePatterns.empty() && std::none_of(options.CasePatterns.begin(), options.CasePatterns.end(), [&](std::string_view pattern) { return PeepoHappy::ASCII::MatchesGlobInsensitive(benchmarkCase.Name, pattern); }))
+				continue;
+
+			std::string farcPath;
+			farcPath.append(options.DataDirectory).append("/").append(benchmarkCase.Name).append(options.Quick ? "_quick.farc" : ".farc");
+
+			if (PeepoHappy::IO::GetFileSize(farcPath) == 0)
+			{
+				fprintf(stderr, "Generating '%s'\n", farcPath.c_str());
+				if (!WriteSyntheticFArc(farcPath, benchmarkCase.Settings, scaleDivisor, options.JobCount))
+				{
+					fprintf(stderr, "[ERROR] Failed to generate '%s'\n", farcPath.c_str());
+					failedCaseCount++;
+					continue;
+				}
+			}
+
+			if (options.GenerateOnly)
+				continue;
+
+			if (!RunBenchmarkCase(benchmarkCase, farcPath, options, threadPool, results))
+			{
+				fprintf(stderr, "[ERROR] Benchmark case '%.*s' failed\n", static_cast<int>(benchmarkCase.Name.size()), benchmarkCase.Name.data());
+				failedCaseCount++;
+			}
+		}
+
+		if (!options.GenerateOnly)
+			PrintResults(results, options.Format);
+
+		return (failedCaseCount == 0) ? EXIT_WIDEPEEPOHAPPY : EXIT_WIDEPEEPOSAD;
+	}
+}
+
+int main()
+{
+	return FArcBenchmark::EntryPoint();
+}
@@ -0,0 +1,389 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+
+#include <limits>
+#include <cstring>
+
+#include <zlib/zlib.h>
+#include <zstd/zstd.h>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+namespace PeepoHappy
+{
+	namespace ZLIB
+	{
+		inline auto DllHandle = ::LoadLibraryW(PeepoHappy::UTF8::WideArg("zlib.dll").c_str());
+		inline auto InflateInit2_ = reinterpret_cast<int(*)(z_streamp strm, int windowBits, const char *version, int stream_size)>(::GetProcAddress(DllHandle, "inflateInit2_"));
+		inline auto Inflate = reinterpret_cast<int(*)(z_streamp strm, int flush)>(::GetProcAddress(DllHandle, "inflate"));
+		inline auto InflateReset2 = reinterpret_cast<int(*)(z_streamp strm, int windowBits)>(::GetProcAddress(DllHandle, "inflateReset2"));
+		inline auto InflateEnd = reinterpret_cast<int(*)(z_streamp strm)>(::GetProcAddress(DllHandle, "inflateEnd"));
+		inline auto DeflateInit2_ = reinterpret_cast<int(*)(z_streamp strm, int level, int method, int windowBits, int memLevel, int strategy, const char *version, int stream_size)>(::GetProcAddress(DllHandle, "deflateInit2_"));
+		inline auto Deflate = reinterpret_cast<int(*)(z_streamp strm, int flush)>(::GetProcAddress(DllHandle, "deflate"));
+		inline auto DeflateBound = reinterpret_cast<uLong(*)(z_streamp strm, uLong sourceLen)>(::GetProcAddress(DllHandle, "deflateBound"));
+		inline auto DeflateReset = reinterpret_cast<int(*)(z_streamp strm)>(::GetProcAddress(DllHandle, "deflateReset"));
+		inline auto DeflateEnd = reinterpret_cast<int(*)(z_streamp strm)>(::GetProcAddress(DllHandle, "deflateEnd"));
+		// NOTE: No need to ::FreeLibrary(DllHandle); for static lifetime
+	}
+
+	namespace ZSTD
+	{
+		inline auto DllHandle = ::LoadLibraryW(PeepoHappy::UTF8::WideArg("libzstd.dll").c_str());
+		inline auto GetFrameContentSize = reinterpret_cast<unsigned long long(*)(const void *src, size_t srcSize)>(::GetProcAddress(DllHandle, "ZSTD_getFrameContentSize"));
+		inline auto Decompress = reinterpret_cast<size_t(*)(void* dst, size_t dstCapacity, const void* src, size_t compressedSize)>(::GetProcAddress(DllHandle, "ZSTD_decompress"));
+		inline auto IsError = reinterpret_cast<unsigned(*)(size_t code)>(::GetProcAddress(DllHandle, "ZSTD_isError"));
+		inline auto CreateDCtx = reinterpret_cast<ZSTD_DCtx*(*)()>(::GetProcAddress(DllHandle, "ZSTD_createDCtx"));
+		inline auto FreeDCtx = reinterpret_cast<size_t(*)(ZSTD_DCtx* dctx)>(::GetProcAddress(DllHandle, "ZSTD_freeDCtx"));
+		inline auto DecompressDCtx = reinterpret_cast<size_t(*)(ZSTD_DCtx* dctx, void* dst, size_t dstCapacity, const void* src, size_t srcSize)>(::GetProcAddress(DllHandle, "ZSTD_decompressDCtx"));
+		inline auto CompressBound = reinterpret_cast<size_t(*)(size_t srcSize)>(::GetProcAddress(DllHandle, "ZSTD_compressBound"));
+		inline auto CreateCCtx = reinterpret_cast<ZSTD_CCtx*(*)()>(::GetProcAddress(DllHandle, "ZSTD_createCCtx"));
+		inline auto FreeCCtx = reinterpret_cast<size_t(*)(ZSTD_CCtx* cctx)>(::GetProcAddress(DllHandle, "ZSTD_freeCCtx"));
+		inline auto CCtxSetParameter = reinterpret_cast<size_t(*)(ZSTD_CCtx* cctx, ZSTD_cParameter param, int value)>(::GetProcAddress(DllHandle, "ZSTD_CCtx_setParameter"));
+		inline auto Compress2 = reinterpret_cast<size_t(*)(ZSTD_CCtx* cctx, void* dst, size_t dstCapacity, const void* src, size_t srcSize)>(::GetProcAddress(DllHandle, "ZSTD_compress2"));
+		// NOTE: No need to ::FreeLibrary(DllHandle); for static lifetime
+	}
+
+	// NOTE: Optional, only used when "libdeflate.dll" can be found otherwise GZip decompression falls back to zlib
+	namespace LIBDEFLATE
+	{
+		struct Decompressor;
+		enum class Result : int { Success = 0, BadData = 1, ShortOutput = 2, InsufficientSpace = 3 };
+
+		inline auto DllHandle = ::LoadLibraryW(PeepoHappy::UTF8::WideArg("libdeflate.dll").c_str());
+		inline auto AllocDecompressor = reinterpret_cast<Decompressor*(*)()>(::GetProcAddress(DllHandle, "libdeflate_alloc_decompressor"));
+		inline auto FreeDecompressor = reinterpret_cast<void(*)(Decompressor* decompressor)>(::GetProcAddress(DllHandle, "libdeflate_free_decompressor"));
+		inline auto GZipDecompress = reinterpret_cast<Result(*)(Decompressor* decompressor, const void* in, size_t inNBytes, void* out, size_t outNBytesAvail, size_t* actualOutNBytesRet)>(::GetProcAddress(DllHandle, "libdeflate_gzip_decompress"));
+		// NOTE: No need to ::FreeLibrary(DllHandle); for static lifetime
+
+		inline bool IsAvailable() { return (AllocDecompressor != nullptr && FreeDecompressor != nullptr && GZipDecompress != nullptr); }
+	}
+
+	namespace Compression
+	{
+		enum class Method
+		{
+			None,
+			GZip,
+			ZStd,
+		};
+
+		constexpr const char* GetMethodName(Method method)
+		{
+			return (method == Method::GZip) ? "gzip" : (method == Method::ZStd) ? "zstd" : "none";
+		}
+
+		enum class GZipBackend
+		{
+			ZLib,
+			LibDeflate,
+		};
+
+		inline GZipBackend GetDefaultGZipBackend()
+		{
+			return LIBDEFLATE::IsAvailable() ? GZipBackend::LibDeflate : GZipBackend::ZLib;
+		}
+
+#pragma pack(push, 1)
+		struct GZipHeader
+		{
+			u8 Magic[2];
+			u8 CompressionMethod;
+			u8 Flags;
+			u32 Timestamp;
+			u8 ExtraFlags;
+			u8 OperatingSystem;
+		};
+#pragma pack(pop)
+
+		static_assert(sizeof(GZipHeader) == 10);
+
+		inline bool HasValidGZipHeader(const u8* fileContent, size_t fileSize)
+		{
+			if (fileSize <= sizeof(GZipHeader))
+				return false;
+
+			const GZipHeader* header = reinterpret_cast<const GZipHeader*>(fileContent);
+			return (header->Magic[0] == 0x1F && header->Magic[1] == 0x8B) && (header->CompressionMethod == Z_DEFLATED);
+		}
+
+		// NOTE: Keeps the zlib inflate and zstd decompression state alive between calls so their windows and tables
+		//		 don't have to be reallocated for every single entry. Not thread safe, use one instance per thread
+		class Decompressor : NonCopyable
+		{
+		public:
+			Decompressor() = default;
+			// NOTE: Falls back to zlib if libdeflate was requested but couldn't be loaded
+			explicit Decompressor(GZipBackend gzipBackend) : gzipBackend((gzipBackend == GZipBackend::LibDeflate && !LIBDEFLATE::IsAvailable()) ? GZipBackend::ZLib : gzipBackend) {}
+			~Decompressor()
+			{
+				if (libDeflateDecompressor != nullptr)
+					LIBDEFLATE::FreeDecompressor(libDeflateDecompressor);
+				if (zStreamInitialized)
+					ZLIB::InflateEnd(&zStream);
+				if (zstdContext != nullptr)
+					ZSTD::FreeDCtx(zstdContext);
+			}
+
+		public:
+			bool Decompress(Method method, const u8* inCompressedData, size_t inDataSize, u8* outDecompressedData, size_t outDataSize)
+			{
+				switch (method)
+				{
+				case Method::None:
+				{
+					if (outDataSize < inDataSize)
+						return false;
+
+					std::memmove(outDecompressedData, inCompressedData, inDataSize);
+					return true;
+				}
+
+				case Method::GZip:
+				{
+					// NOTE: Both backends verify the CRC32 and ISIZE of the GZip trailer as part of the same pass over the data
+					if (gzipBackend == GZipBackend::LibDeflate)
+					{
+						if (libDeflateDecompressor == nullptr && (libDeflateDecompressor = LIBDEFLATE::AllocDecompressor()) == nullptr)
+							return false;
+
+						// NOTE: Without an actual output size pointer libdeflate requires the output buffer to be filled exactly
+						const auto result = LIBDEFLATE::GZipDecompress(libDeflateDecompressor, inCompressedData, inDataSize, outDecompressedData, outDataSize, nullptr);
+						return (result == LIBDEFLATE::Result::Success);
+					}
+
+					constexpr int gzipWindowBits = 31;
+
+					if (!zStreamInitialized)
+					{
+						zStream = {};
+						zStream.zalloc = Z_NULL;
+						zStream.zfree = Z_NULL;
+						zStream.opaque = Z_NULL;
+
+						if (ZLIB::InflateInit2_(&zStream, gzipWindowBits, ZLIB_VERSION, static_cast<int>(sizeof(z_stream))) != Z_OK)
+							return false;
+
+						zStreamInitialized = true;
+					}
+					else if (ZLIB::InflateReset2(&zStream, gzipWindowBits) != Z_OK)
+					{
+						return false;
+					}
+
+					zStream.avail_in = static_cast<uInt>(inDataSize);
+					zStream.next_in = const_cast<Bytef*>(inCompressedData);
+					zStream.avail_out = static_cast<uInt>(outDataSize);
+					zStream.next_out = static_cast<Bytef*>(outDecompressedData);
+
+					// NOTE: A stream ending early would otherwise leave the rest of the output buffer uninitialized
+					const int inflateResult = ZLIB::Inflate(&zStream, Z_FINISH);
+					return (inflateResult == Z_STREAM_END && zStream.avail_out == 0);
+				}
+
+				case Method::ZStd:
+				{
+					if (zstdContext == nullptr && (zstdContext = ZSTD::CreateDCtx()) == nullptr)
+						return false;
+
+					// NOTE: Also verifies the frame checksum if there is one
+					const size_t decompressResult = ZSTD::DecompressDCtx(zstdContext, outDecompressedData, outDataSize, inCompressedData, inDataSize);
+					return (!ZSTD::IsError(decompressResult) && decompressResult == outDataSize);
+				}
+
+				default:
+					assert(false);
+					return false;
+				}
+			}
+
+		private:
+			GZipBackend gzipBackend = GetDefaultGZipBackend();
+			LIBDEFLATE::Decompressor* libDeflateDecompressor = nullptr;
+			z_stream zStream = {};
+			bool zStreamInitialized = false;
+			ZSTD_DCtx* zstdContext = nullptr;
+		};
+
+		constexpr size_t UnknownDecompressedSize = std::numeric_limits<size_t>::max();
+
+		// NOTE: Reads the decompressed size stored inside the zstd frame header or the ISIZE field of the GZip trailer
+		inline size_t GetDecompressedSize(Method method, const u8* inCompressedData, size_t inDataSize)
+		{
+			switch (method)
+			{
+			case Method::None:
+				return inDataSize;
+
+			case Method::GZip:
+			{
+				if (!HasValidGZipHeader(inCompressedData, inDataSize) || inDataSize < (sizeof(GZipHeader) + sizeof(u32) * 2))
+					return UnknownDecompressedSize;
+
+				u32 inputSizeModulo32 = 0;
+				::memcpy(&inputSizeModulo32, inCompressedData + inDataSize - sizeof(u32), sizeof(u32));
+				return inputSizeModulo32;
+			}
+
+			case Method::ZStd:
+			{
+				const unsigned long long frameContentSize = ZSTD::GetFrameContentSize(inCompressedData, inDataSize);
+				return (frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN || frameContentSize == ZSTD_CONTENTSIZE_ERROR) ? UnknownDecompressedSize : static_cast<size_t>(frameContentSize);
+			}
+
+			default:
+				assert(false);
+				return UnknownDecompressedSize;
+			}
+		}
+
+		// NOTE: GZip always ends in a CRC32 of the decompressed data while zstd frames only optionally end in a checksum of their own
+		inline bool HasContentChecksum(Method method, const u8* inCompressedData, size_t inDataSize)
+		{
+			switch (method)
+			{
+			case Method::GZip:
+				return HasValidGZipHeader(inCompressedData, inDataSize);
+
+			case Method::ZStd:
+			{
+				constexpr size_t frameHeaderDescriptorOffset = sizeof(u32);
+				constexpr u8 contentChecksumFlag = (1 << 2);
+				return (inDataSize > frameHeaderDescriptorOffset) && (inCompressedData[frameHeaderDescriptorOffset] & contentChecksumFlag) != 0;
+			}
+
+			default:
+				return false;
+			}
+		}
+
+		inline Decompressor& GetThreadLocalDecompressor()
+		{
+			static thread_local Decompressor threadLocalDecompressor;
+			return threadLocalDecompressor;
+		}
+
+		inline bool Decompress(Method method, const u8* inCompressedData, size_t inDataSize, u8* outDecompressedData, size_t outDataSize)
+		{
+			return GetThreadLocalDecompressor().Decompress(method, inCompressedData, inDataSize, outDecompressedData, outDataSize);
+		}
+
+		constexpr int DefaultGZipLevel = 6;
+		constexpr int DefaultZStdLevel = 3;
+
+		// NOTE: Counterpart to the Decompressor keeping the zlib deflate and zstd compression state alive between calls.
+		//		 GZip output has a zeroed timestamp and zstd frames always include their content size and checksum
+		//		 so the output is deterministic and can be verified by the decompressor. Not thread safe, use one instance per thread
+		class Compressor : NonCopyable
+		{
+		public:
+			Compressor() = default;
+			~Compressor()
+			{
+				if (zStreamInitialized)
+					ZLIB::DeflateEnd(&zStream);
+				if (zstdContext != nullptr)
+					ZSTD::FreeCCtx(zstdContext);
+			}
+
+		public:
+			// NOTE: Replaces the contents of the output vector with the compressed data
+			bool Compress(Method method, const u8* inData, size_t inDataSize, std::vector<u8>& outCompressedData, int level)
+			{
+				switch (method)
+				{
+				case Method::None:
+				{
+					outCompressedData.assign(inData, inData + inDataSize);
+					return true;
+				}
+
+				case Method::GZip:
+				{
+					constexpr int gzipWindowBits = 31;
+					constexpr int defaultMemoryLevel = 8;
+
+					if (zStreamInitialized && zStreamLevel != level)
+					{
+						ZLIB::DeflateEnd(&zStream);
+						zStreamInitialized = false;
+					}
+
+					if (!zStreamInitialized)
+					{
+						zStream = {};
+						if (ZLIB::DeflateInit2_(&zStream, level, Z_DEFLATED, gzipWindowBits, defaultMemoryLevel, Z_DEFAULT_STRATEGY, ZLIB_VERSION, static_cast<int>(sizeof(z_stream))) != Z_OK)
+							return false;
+
+						zStreamInitialized = true;
+						zStreamLevel = level;
+					}
+					else if (ZLIB::DeflateReset(&zStream) != Z_OK)
+					{
+						return false;
+					}
+
+					outCompressedData.resize(ZLIB::DeflateBound(&zStream, static_cast<uLong>(inDataSize)));
+					zStream.avail_in = static_cast<uInt>(inDataSize);
+					zStream.next_in = const_cast<Bytef*>(inData);
+					zStream.avail_out = static_cast<uInt>(outCompressedData.size());
+					zStream.next_out = outCompressedData.data();
+
+					if (ZLIB::Deflate(&zStream, Z_FINISH) != Z_STREAM_END)
+						return false;
+
+					outCompressedData.resize(outCompressedData.size() - zStream.avail_out);
+					return true;
+				}
+
+				case Method::ZStd:
+				{
+					if (zstdContext == nullptr)
+					{
+						if ((zstdContext = ZSTD::CreateCCtx()) == nullptr)
+							return false;
+
+						ZSTD::CCtxSetParameter(zstdContext, ZSTD_c_contentSizeFlag, 1);
+						ZSTD::CCtxSetParameter(zstdContext, ZSTD_c_checksumFlag, 1);
+					}
+
+					if (ZSTD::IsError(ZSTD::CCtxSetParameter(zstdContext, ZSTD_c_compressionLevel, level)))
+						return false;
+
+					outCompressedData.resize(ZSTD::CompressBound(inDataSize));
+					const size_t compressResult = ZSTD::Compress2(zstdContext, outCompressedData.data(), outCompressedData.size(), inData, inDataSize);
+					if (ZSTD::IsError(compressResult))
+						return false;
+
+					outCompressedData.resize(compressResult);
+					return true;
+				}
+
+				default:
+					assert(false);
+					return false;
+				}
+			}
+
+		private:
+			z_stream zStream = {};
+			bool zStreamInitialized = false;
+			int zStreamLevel = 0;
+			ZSTD_CCtx* zstdContext = nullptr;
+		};
+
+		inline Compressor& GetThreadLocalCompressor()
+		{
+			static thread_local Compressor threadLocalCompressor;
+			return threadLocalCompressor;
+		}
+
+		inline bool Compress(Method method, const u8* inData, size_t inDataSize, std::vector<u8>& outCompressedData, int level)
+		{
+			return GetThreadLocalCompressor().Compress(method, inData, inDataSize, outCompressedData, level);
+		}
+	}
+
+}
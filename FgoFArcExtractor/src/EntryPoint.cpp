@@ -1,330 +1,976 @@
 #include "Types.h"
 #include "Utilities.h"
+#include "FArc.h"
+#include "FArcBuilder.h"
+#include "FArcUpdater.h"
 
-#include <zlib/zlib.h>
-#include <zstd/zstd.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <limits>
 
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <Windows.h>
-
-namespace PeepoHappy
+namespace FArcExtractor
 {
-	namespace ZLIB
+	enum class FArcReportFormat
 	{
-		inline auto DllHandle = ::LoadLibraryW(PeepoHappy::UTF8::WideArg("zlib.dll").c_str());
-		inline auto InflateInit2_ = reinterpret_cast<int(*)(z_streamp strm, int windowBits, const char *version, int stream_size)>(::GetProcAddress(DllHandle, "inflateInit2_"));
-		inline auto Inflate = reinterpret_cast<int(*)(z_streamp strm, int flush)>(::GetProcAddress(DllHandle, "inflate"));
-		inline auto InflateEnd = reinterpret_cast<int(*)(z_streamp strm)>(::GetProcAddress(DllHandle, "inflateEnd"));
-		// NOTE: No need to ::FreeLibrary(DllHandle); for static lifetime
-	}
+		Text,
+		Json,
+		Csv,
+	};
 
-	namespace ZSTD
+	struct CommandLineOptions
 	{
-		inline auto DllHandle = ::LoadLibraryW(PeepoHappy::UTF8::WideArg("libzstd.dll").c_str());
-		inline auto GetFrameContentSize = reinterpret_cast<unsigned long long(*)(const void *src, size_t srcSize)>(::GetProcAddress(DllHandle, "ZSTD_getFrameContentSize"));
-		inline auto Decompress = reinterpret_cast<size_t(*)(void* dst, size_t dstCapacity, const void* src, size_t compressedSize)>(::GetProcAddress(DllHandle, "ZSTD_decompress"));
-		inline auto IsError = reinterpret_cast<unsigned(*)(size_t code)>(::GetProcAddress(DllHandle, "ZSTD_decompress"));
-		// NOTE: No need to ::FreeLibrary(DllHandle); for static lifetime
-	}
+		std::string_view InputFArcPath;
+		std::string_view ExtractFileName;
+		std::vector<std::string_view> IncludePatterns;
+		std::vector<std::string_view> ExcludePatterns;
+		u32 JobCount = 1;
+		bool Pipelined = false;
+		size_t MaxMemoryBytes = 0;
+		bool DirectWrite = false;
+		bool UseEntryIndexCache = false;
+		bool ListEntries = false;
+		bool VerifyEntries = false;
+		FArcReportFormat ReportFormat = FArcReportFormat::Text;
+		std::vector<std::string_view> BatchDirectories;
+		std::vector<std::string_view> BatchListFiles;
+		std::string_view TraceOutputPath;
+		std::string_view PackDirectory;
+		FArcBuildSettings PackSettings = {};
+		std::vector<std::string_view> ReplaceFilePaths;
+		std::string_view DedupStoreDirectory;
+		bool Incremental = false;
+
+		bool IsBatch() const { return (!BatchDirectories.empty() || !BatchListFiles.empty()); }
+	};
 
-	namespace Compression
+	// NOTE: Plain byte count with an optional (case insensitive) K, M or G binary unit suffix, for example "512M"
+	bool ParseByteSizeString(std::string_view value, size_t& outByteSize)
 	{
-		enum class Method
+		size_t unitMultiplier = 1;
+		if (!value.empty())
 		{
-			None,
-			GZip,
-			ZStd,
-		};
+			switch (PeepoHappy::ASCII::ToUpperCase(value.back()))
+			{
+			case 'K': unitMultiplier = (1ull << 10); break;
+			case 'M': unitMultiplier = (1ull << 20); break;
+			case 'G': unitMultiplier = (1ull << 30); break;
+			}
 
-#pragma pack(push, 1)
-		struct GZipHeader
-		{
-			u8 Magic[2];
-			u8 CompressionMethod;
-			u8 Flags;
-			u32 Timestamp;
-			u8 ExtraFlags;
-			u8 OperatingSystem;
-		};
-#pragma pack(pop)
+			if (unitMultiplier != 1)
+				value.remove_suffix(1);
+		}
 
-		static_assert(sizeof(GZipHeader) == 10);
+		u64 count = 0;
+		if (auto[end, error] = std::from_chars(value.data(), value.data() + value.size(), count); error != std::errc() || end != value.data() + value.size() || value.empty())
+			return false;
 
-		inline bool HasValidGZipHeader(const u8* fileContent, size_t fileSize)
-		{
-			if (fileSize <= sizeof(GZipHeader))
-				return false;
+		if (count > (std::numeric_limits<size_t>::max() / unitMultiplier))
+			return false;
 
-			const GZipHeader* header = reinterpret_cast<const GZipHeader*>(fileContent);
-			return (header->Magic[0] == 0x1F && header->Magic[1] == 0x8B) && (header->CompressionMethod == Z_DEFLATED);
-		}
+		outByteSize = static_cast<size_t>(count * unitMultiplier);
+		return true;
+	}
 
-		inline bool Decompress(Method method, const u8* inCompressedData, size_t inDataSize, u8* outDecompressedData, size_t outDataSize)
+	bool ParseCommandLineOptions(int argc, const char** argv, CommandLineOptions& outOptions)
+	{
+		for (int i = 1; i < argc; i++)
 		{
-			switch (method)
-			{
-			case Method::None:
+			const auto argument = std::string_view(argv[i]);
+			std::string_view value;
+
+			auto readOptionValue = [&]() -> bool
 			{
-				if (outDataSize < inDataSize)
+				if (i + 1 >= argc)
+				{
+					fprintf(stderr, "[ERROR] Missing value for '%s'\n", argv[i]);
 					return false;
+				}
 
-				std::memmove(outDecompressedData, inCompressedData, inDataSize);
+				value = std::string_view(argv[++i]);
 				return true;
+			};
+
+			if (PeepoHappy::ASCII::Matches(argument, "--jobs") || PeepoHappy::ASCII::Matches(argument, "-j"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				u32 jobCount = 0;
+				if (auto[end, error] = std::from_chars(value.data(), value.data() + value.size(), jobCount); error != std::errc() || end != value.data() + value.size())
+				{
+					fprintf(stderr, "[ERROR] Invalid job count '%s'\n", argv[i]);
+					return false;
+				}
+
+				outOptions.JobCount = (jobCount == 0) ? PeepoHappy::Threading::GetHardwareThreadCount() : jobCount;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--extract") || PeepoHappy::ASCII::Matches(argument, "-x"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				outOptions.ExtractFileName = value;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--pipeline"))
+			{
+				outOptions.Pipelined = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--direct"))
+			{
+				outOptions.DirectWrite = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--index-cache"))
+			{
+				outOptions.UseEntryIndexCache = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--dedup-store"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				outOptions.DedupStoreDirectory = value;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--incremental"))
+			{
+				outOptions.Incremental = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--list") || PeepoHappy::ASCII::Matches(argument, "-l"))
+			{
+				outOptions.ListEntries = true;
 			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--verify"))
+			{
+				outOptions.VerifyEntries = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--format"))
+			{
+				if (!readOptionValue())
+					return false;
 
-			case Method::GZip:
+				if (PeepoHappy::ASCII::MatchesInsensitive(value, "text"))
+					outOptions.ReportFormat = FArcReportFormat::Text;
+				else if (PeepoHappy::ASCII::MatchesInsensitive(value, "json"))
+					outOptions.ReportFormat = FArcReportFormat::Json;
+				else if (PeepoHappy::ASCII::MatchesInsensitive(value, "csv"))
+					outOptions.ReportFormat = FArcReportFormat::Csv;
+				else
+				{
+					fprintf(stderr, "[ERROR] Unknown report format '%s'\n", argv[i]);
+					return false;
+				}
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--max-memory"))
 			{
-				z_stream zStream = {};
-				zStream.zalloc = Z_NULL;
-				zStream.zfree = Z_NULL;
-				zStream.opaque = Z_NULL;
-				zStream.avail_in = static_cast<uInt>(inDataSize);
-				zStream.next_in = const_cast<Bytef*>(inCompressedData);
-				zStream.avail_out = static_cast<uInt>(outDataSize);
-				zStream.next_out = static_cast<Bytef*>(outDecompressedData);
+				if (!readOptionValue())
+					return false;
+
+				if (!ParseByteSizeString(value, outOptions.MaxMemoryBytes) || outOptions.MaxMemoryBytes == 0)
+				{
+					fprintf(stderr, "[ERROR] Invalid memory size '%s'\n", argv[i]);
+					return false;
+				}
 
-				const int initResult = ZLIB::InflateInit2_(&zStream, 31, ZLIB_VERSION, static_cast<int>(sizeof(z_stream)));
-				if (initResult != Z_OK)
+				// NOTE: Bounding the memory use requires entries to be written while others are still being decompressed
+				outOptions.Pipelined = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--include") || PeepoHappy::ASCII::Matches(argument, "--exclude"))
+			{
+				if (!readOptionValue())
 					return false;
 
-				const int inflateResult = ZLIB::Inflate(&zStream, Z_FINISH);
+				auto& patterns = PeepoHappy::ASCII::Matches(argument, "--include") ? outOptions.IncludePatterns : outOptions.ExcludePatterns;
+				patterns.push_back(value);
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--trace"))
+			{
+				if (!readOptionValue())
+					return false;
 
-				const int endResult = ZLIB::InflateEnd(&zStream);
-				if (endResult != Z_OK)
+				outOptions.TraceOutputPath = value;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--pack"))
+			{
+				if (!readOptionValue())
 					return false;
 
-				return true;
+				outOptions.PackDirectory = value;
 			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--replace"))
+			{
+				if (!readOptionValue())
+					return false;
 
-			case Method::ZStd:
+				outOptions.ReplaceFilePaths.push_back(value);
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--method"))
 			{
-				const size_t decompressResult = ZSTD::Decompress(outDecompressedData, outDataSize, inCompressedData, inDataSize);
+				if (!readOptionValue())
+					return false;
 
-				return true;
+				if (PeepoHappy::ASCII::MatchesInsensitive(value, "gzip"))
+					outOptions.PackSettings.CompressionMethod = PeepoHappy::Compression::Method::GZip;
+				else if (PeepoHappy::ASCII::MatchesInsensitive(value, "zstd"))
+					outOptions.PackSettings.CompressionMethod = PeepoHappy::Compression::Method::ZStd;
+				else if (PeepoHappy::ASCII::MatchesInsensitive(value, "none"))
+					outOptions.PackSettings.CompressionMethod = PeepoHappy::Compression::Method::None;
+				else
+				{
+					fprintf(stderr, "[ERROR] Unknown compression method '%s'\n", argv[i]);
+					return false;
+				}
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--level"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				int level = 0;
+				if (auto[end, error] = std::from_chars(value.data(), value.data() + value.size(), level); error != std::errc() || end != value.data() + value.size())
+				{
+					fprintf(stderr, "[ERROR] Invalid compression level '%s'\n", argv[i]);
+					return false;
+				}
+
+				outOptions.PackSettings.CompressionLevel = level;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--split-chunks"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				if (!ParseByteSizeString(value, outOptions.PackSettings.SplitChunkSize) || outOptions.PackSettings.SplitChunkSize > std::numeric_limits<u32>::max())
+				{
+					fprintf(stderr, "[ERROR] Invalid chunk size '%s'\n", argv[i]);
+					return false;
+				}
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--encrypt"))
+			{
+				outOptions.PackSettings.Encrypted = true;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--signature"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				// NOTE: Case sensitive on purpose since the signatures only differ in case
+				if (PeepoHappy::ASCII::Matches(value, "FArC"))
+					outOptions.PackSettings.Signature = FArcSignature::FArC;
+				else if (PeepoHappy::ASCII::Matches(value, "FARC"))
+					outOptions.PackSettings.Signature = FArcSignature::FARC;
+				else if (PeepoHappy::ASCII::Matches(value, "FARc"))
+					outOptions.PackSettings.Signature = FArcSignature::FARc;
+				else
+				{
+					fprintf(stderr, "[ERROR] Unknown signature '%s'\n", argv[i]);
+					return false;
+				}
 			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--alignment"))
+			{
+				if (!readOptionValue())
+					return false;
 
-			default:
-				assert(false);
+				u32 alignment = 0;
+				if (auto[end, error] = std::from_chars(value.data(), value.data() + value.size(), alignment); error != std::errc() || end != value.data() + value.size() || alignment == 0 || (alignment & (alignment - 1)) != 0)
+				{
+					fprintf(stderr, "[ERROR] Invalid alignment '%s', must be a power of two\n", argv[i]);
+					return false;
+				}
+
+				outOptions.PackSettings.Alignment = alignment;
+			}
+			else if (PeepoHappy::ASCII::Matches(argument, "--batch"))
+			{
+				if (!readOptionValue())
+					return false;
+
+				outOptions.BatchDirectories.push_back(value);
+			}
+			else if (PeepoHappy::ASCII::StartsWith(argument, "--"))
+			{
+				fprintf(stderr, "[ERROR] Unknown option '%s'\n", argv[i]);
+				return false;
+			}
+			else if (PeepoHappy::ASCII::StartsWith(argument, "@") && argument.size() > 1)
+			{
+				outOptions.BatchListFiles.push_back(argument.substr(1));
+			}
+			else if (outOptions.InputFArcPath.empty())
+			{
+				outOptions.InputFArcPath = argument;
+			}
+			else
+			{
+				fprintf(stderr, "[ERROR] Unexpected argument '%s'\n", argv[i]);
 				return false;
 			}
 		}
-	}
 
-}
+		if (outOptions.DirectWrite && outOptions.Pipelined)
+		{
+			fprintf(stderr, "[ERROR] --direct can't be combined with --pipeline or --max-memory\n");
+			return false;
+		}
 
-namespace FArcExtractor
-{
-	namespace
-	{
-		inline u16 ByteSwapU16(u16 value) { return _byteswap_ushort(value); }
-		inline u32 ByteSwapU32(u32 value) { return _byteswap_ulong(value); }
-		inline u64 ByteSwapU64(u64 value) { return _byteswap_uint64(value); }
+		if (!outOptions.ExtractFileName.empty() && (outOptions.Pipelined || !outOptions.IncludePatterns.empty() || !outOptions.ExcludePatterns.empty()))
+		{
+			fprintf(stderr, "[ERROR] --extract can't be combined with --pipeline, --max-memory, --include or --exclude\n");
+			return false;
+		}
+
+		if (!outOptions.DedupStoreDirectory.empty() && (outOptions.DirectWrite || outOptions.ListEntries || outOptions.VerifyEntries || !outOptions.PackDirectory.empty() || !outOptions.ReplaceFilePaths.empty()))
+		{
+			fprintf(stderr, "[ERROR] --dedup-store can't be combined with --direct, --list, --verify, --pack or --replace\n");
+			return false;
+		}
+
+		if (outOptions.Incremental && (!outOptions.ExtractFileName.empty() || outOptions.ListEntries || outOptions.VerifyEntries || !outOptions.PackDirectory.empty() || !outOptions.ReplaceFilePaths.empty()))
+		{
+			fprintf(stderr, "[ERROR] --incremental can't be combined with --extract, --list, --verify, --pack or --replace\n");
+			return false;
+		}
+
+		if (outOptions.VerifyEntries && (outOptions.ListEntries || !outOptions.ExtractFileName.empty() || outOptions.Pipelined || outOptions.DirectWrite))
+		{
+			fprintf(stderr, "[ERROR] --verify can't be combined with --list, --extract, --pipeline, --max-memory or --direct\n");
+			return false;
+		}
+
+		if (!outOptions.PackDirectory.empty())
+		{
+			if (outOptions.ListEntries || outOptions.VerifyEntries || !outOptions.ExtractFileName.empty() || outOptions.DirectWrite || outOptions.UseEntryIndexCache || outOptions.IsBatch() || !outOptions.ReplaceFilePaths.empty())
+			{
+				fprintf(stderr, "[ERROR] --pack can't be combined with --list, --verify, --extract, --direct, --index-cache, --replace or batch mode\n");
+				return false;
+			}
+
+			const auto method = outOptions.PackSettings.CompressionMethod;
+			const auto level = outOptions.PackSettings.CompressionLevel;
+			if (level.has_value() && ((method == PeepoHappy::Compression::Method::GZip && (*level < 0 || *level > 9)) || (method == PeepoHappy::Compression::Method::ZStd && (*level < 1 || *level > 22))))
+			{
+				fprintf(stderr, "[ERROR] Compression level %d is out of range, gzip supports 0 to 9 and zstd 1 to 22\n", *level);
+				return false;
+			}
+
+			// NOTE: The positional path names the output archive
+			return !outOptions.InputFArcPath.empty();
+		}
+
+		if (!outOptions.ReplaceFilePaths.empty())
+		{
+			if (outOptions.ListEntries || outOptions.VerifyEntries || !outOptions.ExtractFileName.empty() || outOptions.Pipelined || outOptions.DirectWrite || outOptions.IsBatch())
+			{
+				fprintf(stderr, "[ERROR] --replace can't be combined with --list, --verify, --extract, --pipeline, --max-memory, --direct or batch mode\n");
+				return false;
+			}
+
+			// NOTE: Replaced entries keep their own compression method which isn't known until the archive has been opened,
+			//		 so the level has to be valid for both gzip (0 to 9) and zstd (1 to 22)
+			const auto level = outOptions.PackSettings.CompressionLevel;
+			if (level.has_value() && (*level < 1 || *level > 9))
+			{
+				fprintf(stderr, "[ERROR] Compression level %d is out of range, replacing entries supports 1 to 9\n", *level);
+				return false;
+			}
+
+			return !outOptions.InputFArcPath.empty();
+		}
+
+		if (outOptions.IsBatch())
+		{
+			if (!outOptions.InputFArcPath.empty() || !outOptions.ExtractFileName.empty() || outOptions.Pipelined)
+			{
+				fprintf(stderr, "[ERROR] Batch mode can't be combined with an input file, --extract, --pipeline or --max-memory\n");
+				return false;
+			}
+			return true;
+		}
+
+		return !outOptions.InputFArcPath.empty();
 	}
 
-	enum class FArcSignature
+	// NOTE: Collects every .farc file inside the batch directories and every non empty line of the batch list files, largest files first
+	std::vector<std::string> GatherBatchFArcPaths(const CommandLineOptions& options)
 	{
-		Invalid = 0,
-		FArC = 1,
-		FARC = 2,
-		FARc = 3,
-	};
+		std::vector<std::string> farcPaths;
 
-	struct FArcFlags
-	{
-		u32 Unk0 : 1;
-		u32 GZipCompressed : 1;
-		u32 Encrypted : 1;
-		u32 Unk3 : 1;
-		u32 Unk4 : 1;
-		u32 Unk5 : 1;
-		u32 ZStdCompressed : 1;
-		u32 Unk7 : 1;
-	};
+		for (const auto directory : options.BatchDirectories)
+		{
+			const auto trimmedDirectory = PeepoHappy::ASCII::StripSuffix(PeepoHappy::ASCII::StripSuffix(directory, "/"), "\\");
+			if (!PeepoHappy::IO::DirectoryExists(trimmedDirectory))
+			{
+				fprintf(stderr, "[ERROR] Batch directory '%.*s' not found\n", static_cast<int>(directory.size()), directory.data());
+				continue;
+			}
 
-	struct FArcFileFlags
-	{
-		u32 Unk0 : 1;
-		u32 GZipCompressed : 1;
-		u32 Encrypted : 1;
-		u32 Unk3 : 1;
-		u32 SplitChunks : 1;
-		u32 ZStdCompressed : 1;
-	};
+			for (auto& filePath : PeepoHappy::IO::GetFilesInDirectory(trimmedDirectory))
+			{
+				if (PeepoHappy::Path::HasFileExtension(filePath, ".farc"))
+					farcPaths.push_back(std::move(filePath));
+			}
+		}
 
-	struct FArcFileEntry
-	{
-		std::string_view FileName;
-		u32 Offset;
-		u32 CompressedSize;
-		u32 UncompressedSize;
-		FArcFileFlags Flags;
+		for (const auto listFilePath : options.BatchListFiles)
+		{
+			const auto[listFileContent, listFileSize] = PeepoHappy::IO::ReadEntireFile(listFilePath);
+			if (listFileContent == nullptr)
+			{
+				fprintf(stderr, "[ERROR] Batch list file '%.*s' not found\n", static_cast<int>(listFilePath.size()), listFilePath.data());
+				continue;
+			}
 
-		std::unique_ptr<u8[]> DecompressedFileContent;
-	};
+			auto remainingLines = std::string_view(reinterpret_cast<const char*>(listFileContent.get()), listFileSize);
+			while (!remainingLines.empty())
+			{
+				const size_t lineEnd = remainingLines.find('\n');
+				const auto line = PeepoHappy::ASCII::Trim(remainingLines.substr(0, lineEnd));
+				remainingLines = (lineEnd == std::string_view::npos) ? std::string_view() : remainingLines.substr(lineEnd + 1);
+
+				if (!line.empty())
+					farcPaths.emplace_back(line);
+			}
+		}
+
+		std::vector<std::pair<u64, std::string>> sizedFArcPaths;
+		sizedFArcPaths.reserve(farcPaths.size());
+		for (auto& path : farcPaths)
+			sizedFArcPaths.emplace_back(PeepoHappy::IO::GetFileSize(path), std::move(path));
+
+		std::stable_sort(sizedFArcPaths.begin(), sizedFArcPaths.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+		farcPaths.clear();
+		for (auto&[size, path] : sizedFArcPaths)
+			farcPaths.push_back(std::move(path));
+		return farcPaths;
+	}
+
+	std::string_view GetFArcSignatureName(FArcSignature signature)
+	{
+		switch (signature)
+		{
+		case FArcSignature::FArC: return "FArC";
+		case FArcSignature::FARC: return "FARC";
+		case FArcSignature::FARc: return "FARc";
+		default: return "Invalid";
+		}
+	}
 
-	struct FArc
+	// NOTE: Appends the names of all set flags separated by the separator, or "none" if there aren't any
+	void AppendFArcFileFlagNames(std::string& outString, FArcFileFlags flags, std::string_view separator, std::string_view quote = "")
 	{
-		std::unique_ptr<u8[]> FileContent;
-		size_t FileSize;
+		const std::pair<bool, std::string_view> flagNames[] =
+		{
+			{ flags.Unk0 != 0, "unk0" },
+			{ flags.GZipCompressed != 0, "gzip" },
+			{ flags.Encrypted != 0, "encrypted" },
+			{ flags.Unk3 != 0, "unk3" },
+			{ flags.SplitChunks != 0, "split_chunks" },
+			{ flags.ZStdCompressed != 0, "zstd" },
+		};
 
-		FArcSignature Signature;
-		FArcFlags Flags;
-		std::vector<FArcFileEntry> Entries;
-	};
+		bool isFirst = true;
+		for (const auto&[isSet, name] : flagNames)
+		{
+			if (!isSet)
+				continue;
+
+			outString.append(isFirst ? "" : separator).append(quote).append(name).append(quote);
+			isFirst = false;
+		}
 
-	static_assert(sizeof(FArcFileFlags) == sizeof(u32));
-	static_assert(sizeof(FArcFlags) == sizeof(u32));
+		if (isFirst && quote.empty())
+			outString.append("none");
+	}
 
-	FArc OpenReadDecryptAndParseFArcEntries(std::string_view inputFArcPath)
+	void AppendCsvEscapedString(std::string& outString, std::string_view value)
 	{
-		FArc outFArc = {};
+		if (value.find_first_of(",\"\r\n") == std::string_view::npos)
+		{
+			outString.append(value);
+			return;
+		}
 
-		auto[fileContent, fileSize] = PeepoHappy::IO::ReadEntireFile(inputFArcPath);
-		outFArc.FileContent = std::move(fileContent);
-		outFArc.FileSize = fileSize;
+		outString.push_back('"');
+		for (const char c : value)
+		{
+			if (c == '"')
+				outString.push_back('"');
+			outString.push_back(c);
+		}
+		outString.push_back('"');
+	}
 
-		const u8* readHead = outFArc.FileContent.get();
-		const u32 signature = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+	// NOTE: JSON output is a single array containing one object per archive, so isFirstArchive is needed to place the separators in between
+	void AppendFArcListing(std::string& outString, std::string_view farcPath, const FArc& inFArc, FArcReportFormat format, bool isFirstArchive)
+	{
+		char formatBuffer[128];
 
-		outFArc.Signature = (signature == 'FArC') ? FArcSignature::FArC : (signature == 'FARC') ? FArcSignature::FARC : (signature == 'FARc') ? FArcSignature::FARc : FArcSignature::Invalid;
-		if (outFArc.Signature == FArcSignature::Invalid)
+		if (format == FArcReportFormat::Text)
 		{
-			fprintf(stderr, "[ERROR] Unexpected FArc signature!\n");
+			outString.append(farcPath);
+			snprintf(formatBuffer, sizeof(formatBuffer), " (%.*s%s, %zu entries)\n", static_cast<int>(GetFArcSignatureName(inFArc.Signature).size()), GetFArcSignatureName(inFArc.Signature).data(),
+				inFArc.Flags.Encrypted ? ", encrypted" : "", inFArc.Entries.size());
+			outString.append(formatBuffer);
+
+			for (const auto& entry : inFArc.Entries)
+			{
+				snprintf(formatBuffer, sizeof(formatBuffer), "    %10u %10u %10u  ", entry.Offset, entry.CompressedSize, entry.UncompressedSize);
+				outString.append(formatBuffer).append(entry.FileName).append("  [");
+				AppendFArcFileFlagNames(outString, entry.Flags, ", ");
+				outString.append("]\n");
+			}
 		}
-		else
+		else if (format == FArcReportFormat::Json)
 		{
-			const u32 headerSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-			const u32 farcFlags = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-			const u32 unkAlways0 = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+			outString.append(isFirstArchive ? "[\n" : ",\n").append("  { \"archive\": ");
+			PeepoHappy::JSON::AppendEscapedString(outString, farcPath);
+			outString.append(", \"signature\": ");
+			PeepoHappy::JSON::AppendEscapedString(outString, GetFArcSignatureName(inFArc.Signature));
+			outString.append(inFArc.Flags.Encrypted ? ", \"encrypted\": true, \"entries\": [" : ", \"encrypted\": false, \"entries\": [");
 
-			outFArc.Flags = *reinterpret_cast<const FArcFlags*>(&farcFlags);
-			if (outFArc.Flags.Encrypted)
+			for (const auto& entry : inFArc.Entries)
 			{
-				const auto key = PeepoHappy::Crypto::ParseAes128KeyHexByteString("62EC7CD79141695E53592ACC10CDC04C");
-				constexpr size_t encryptedDataOffset = 16 /* unencrypted start of header */ + PeepoHappy::Crypto::Aes128IVSize;
+				outString.append((&entry == inFArc.Entries.data()) ? "\n    { \"name\": " : ",\n    { \"name\": ");
+				PeepoHappy::JSON::AppendEscapedString(outString, entry.FileName);
+				snprintf(formatBuffer, sizeof(formatBuffer), ", \"offset\": %u, \"compressed_size\": %u, \"uncompressed_size\": %u, \"flags\": [", entry.Offset, entry.CompressedSize, entry.UncompressedSize);
+				outString.append(formatBuffer);
+				AppendFArcFileFlagNames(outString, entry.Flags, ", ", "\"");
+				outString.append("] }");
+			}
 
-				PeepoHappy::Crypto::Aes128IVBytes iv = {};
-				::memcpy(iv.data(), outFArc.FileContent.get() + sizeof(iv), sizeof(iv));
+			outString.append(inFArc.Entries.empty() ? "] }" : "\n  ] }");
+		}
+		else if (format == FArcReportFormat::Csv)
+		{
+			if (isFirstArchive)
+				outString.append("archive,name,offset,compressed_size,uncompressed_size,flags\n");
 
-				PeepoHappy::Crypto::DecryptAes128Cbc(outFArc.FileContent.get() + encryptedDataOffset, outFArc.FileContent.get() + encryptedDataOffset, outFArc.FileSize - encryptedDataOffset, key, iv);
-				readHead = outFArc.FileContent.get() + encryptedDataOffset;
+			for (const auto& entry : inFArc.Entries)
+			{
+				AppendCsvEscapedString(outString, farcPath);
+				outString.push_back(',');
+				AppendCsvEscapedString(outString, entry.FileName);
+				snprintf(formatBuffer, sizeof(formatBuffer), ",%u,%u,%u,", entry.Offset, entry.CompressedSize, entry.UncompressedSize);
+				outString.append(formatBuffer);
+				AppendFArcFileFlagNames(outString, entry.Flags, "|");
+				outString.push_back('\n');
 			}
+		}
+	}
 
-			const u32 maybeAlignmentA = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-			const u32 unkEither1Or4 = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-			const u32 fileCount = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-			const u32 maybeAlignmentB = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+	// NOTE: Only the header and entry table of each archive are ever read (and decrypted), none of the entry data is touched
+	int RunListing(const CommandLineOptions& options)
+	{
+		std::vector<std::string> farcPaths = options.IsBatch() ? GatherBatchFArcPaths(options) : std::vector<std::string> { std::string(options.InputFArcPath) };
+		if (farcPaths.empty())
+		{
+			fprintf(stderr, "[ERROR] No input FArc files found\n");
+			return EXIT_WIDEPEEPOSAD;
+		}
 
-			outFArc.Entries.reserve(fileCount);
-			for (size_t i = 0; i < fileCount; i++)
-			{
-				auto& entry = outFArc.Entries.emplace_back();
-				entry.FileName = std::string_view(reinterpret_cast<const char*>(readHead)); readHead += entry.FileName.size() + sizeof('\0');
-				entry.Offset = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-				entry.CompressedSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-				entry.UncompressedSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-				const u32 fileFlags = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
-				entry.Flags = *reinterpret_cast<const FArcFileFlags*>(&fileFlags);
+		size_t failedArchiveCount = 0;
+		bool isFirstArchive = true;
+		std::string listing;
 
-				if (outFArc.Flags.Encrypted)
-					entry.Offset += static_cast<u32>(PeepoHappy::Crypto::Aes128KeySize);
+		for (const auto& farcPath : farcPaths)
+		{
+			auto farc = OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy, options.UseEntryIndexCache);
+			if (!farc.File.IsOpen() || farc.Signature == FArcSignature::Invalid)
+			{
+				fprintf(stderr, "[ERROR] Failed to list '%s'\n", farcPath.c_str());
+				failedArchiveCount++;
+				continue;
 			}
+
+			FilterFArcEntries(farc, options.IncludePatterns, options.ExcludePatterns);
+
+			listing.clear();
+			AppendFArcListing(listing, farcPath, farc, options.ReportFormat, isFirstArchive);
+			fwrite(listing.data(), sizeof(char), listing.size(), stdout);
+			isFirstArchive = false;
 		}
 
-		return outFArc;
+		if (options.ReportFormat == FArcReportFormat::Json)
+			fputs(isFirstArchive ? "[]\n" : "\n]\n", stdout);
+
+		return (failedArchiveCount == 0) ? EXIT_WIDEPEEPOHAPPY : EXIT_WIDEPEEPOSAD;
 	}
 
-	bool ReadAndDecompressAllFArcEntries(FArc& inOutFArc)
+	enum class FArcEntryVerifyStatus
 	{
-		if (inOutFArc.FileContent == nullptr || inOutFArc.FileSize < 16)
-			return false;
+		Ok,
+		Unreadable,
+		Corrupt,
+	};
+
+	struct FArcEntryVerifyResult
+	{
+		FArcEntryVerifyStatus Status = FArcEntryVerifyStatus::Unreadable;
+		// NOTE: Whether the decompressor had a GZip CRC32 or zstd frame checksum to check the decompressed data against
+		bool HasContentChecksum = false;
+		u64 ContentHash = 0;
+	};
+
+	std::string_view GetFArcEntryVerifyStatusName(FArcEntryVerifyStatus status)
+	{
+		switch (status)
+		{
+		case FArcEntryVerifyStatus::Ok: return "ok";
+		case FArcEntryVerifyStatus::Unreadable: return "unreadable";
+		case FArcEntryVerifyStatus::Corrupt: return "corrupt";
+		default: return "unknown";
+		}
+	}
 
-		for (auto& entry : inOutFArc.Entries)
+	// NOTE: Decompresses every entry without writing anything, relying on the decompressors to check the GZip CRC32 / ISIZE trailer
+	//		 and the zstd frame checksum (if present) while hashing the decompressed data so it can be compared against other extractions
+	std::vector<FArcEntryVerifyResult> VerifyFArcEntries(const FArc& inFArc, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		std::vector<FArcEntryVerifyResult> results(inFArc.Entries.size());
+
+		auto verifyEntry = [&inFArc, &results, threadPool](size_t entryIndex)
 		{
-			entry.DecompressedFileContent = std::make_unique<u8[]>(entry.UncompressedSize);
-			const u8* readHead = (inOutFArc.FileContent.get() + entry.Offset);
+			const auto& entry = inFArc.Entries[entryIndex];
+			auto& result = results[entryIndex];
 
-			if (entry.Flags.SplitChunks)
+			std::vector<u8> decryptedEntryData;
+			const u8* entryData = ReadFArcEntryData(inFArc, entry, decryptedEntryData);
+			if (entryData == nullptr)
 			{
-				const u32 strangeUnkownData = *reinterpret_cast<const u32*>(readHead); readHead += sizeof(u32);
-				u32 remainingCompressedSize = (entry.CompressedSize - static_cast<u32>(sizeof(strangeUnkownData)));
+				result.Status = FArcEntryVerifyStatus::Unreadable;
+				return;
+			}
 
-				for (size_t safetyLimit = 0; safetyLimit < 0x4000; safetyLimit++)
-				{
-					const u32 chunkSize = *reinterpret_cast<const u32*>(readHead); readHead += sizeof(u32);
+			result.HasContentChecksum = IsFArcEntryDataChecksummed(entryData, entry);
 
-					remainingCompressedSize -= (chunkSize + sizeof(chunkSize));
-					if (remainingCompressedSize <= sizeof(u32))
-						break;
-				}
+			auto decompressedData = inFArc.EntryBufferPool->Allocate(entry.UncompressedSize);
+			if (!DecompressFArcEntryDataInto(entryData, entry, decompressedData.get(), threadPool))
+			{
+				result.Status = FArcEntryVerifyStatus::Corrupt;
+				return;
 			}
 
-			const u32 currentFilePosition = static_cast<u32>(std::distance<const u8*>(inOutFArc.FileContent.get(), readHead));
-			const auto compressedSizeWithoutChunkTable = entry.CompressedSize - (currentFilePosition - entry.Offset);
+			PeepoHappy::Trace::ScopedEvent hashEvent("hash", entry.UncompressedSize, "xxh3", entry.FileName);
+			result.ContentHash = PeepoHappy::Hash::ComputeXXH3(decompressedData.get(), entry.UncompressedSize);
+			result.Status = FArcEntryVerifyStatus::Ok;
+		};
+
+		if (threadPool == nullptr)
+		{
+			for (size_t entryIndex = 0; entryIndex < inFArc.Entries.size(); entryIndex++)
+				verifyEntry(entryIndex);
+			return results;
+		}
+
+		std::vector<size_t> sortedEntryIndices(inFArc.Entries.size());
+		for (size_t entryIndex = 0; entryIndex < sortedEntryIndices.size(); entryIndex++)
+			sortedEntryIndices[entryIndex] = entryIndex;
+
+		std::stable_sort(sortedEntryIndices.begin(), sortedEntryIndices.end(), [&](size_t a, size_t b) { return inFArc.Entries[a].CompressedSize > inFArc.Entries[b].CompressedSize; });
+
+		PeepoHappy::Threading::TaskGroup entryTaskGroup;
+		for (const size_t entryIndex : sortedEntryIndices)
+			threadPool->Enqueue(entryTaskGroup, [&verifyEntry, entryIndex] { verifyEntry(entryIndex); });
+
+		threadPool->Wait(entryTaskGroup);
+		return results;
+	}
+
+	void AppendFArcVerifyReport(std::string& outString, std::string_view farcPath, const FArc& inFArc, const std::vector<FArcEntryVerifyResult>& results, FArcReportFormat format, bool isFirstArchive)
+	{
+		char formatBuffer[128];
+
+		if (format == FArcReportFormat::Text)
+		{
+			outString.append(farcPath).push_back('\n');
 
-			if (entry.Flags.GZipCompressed)
+			for (size_t entryIndex = 0; entryIndex < inFArc.Entries.size(); entryIndex++)
 			{
-				const bool wasSuccessful = PeepoHappy::Compression::Decompress(PeepoHappy::Compression::Method::GZip,
-					readHead, entry.CompressedSize, entry.DecompressedFileContent.get(), entry.UncompressedSize);
+				const auto& entry = inFArc.Entries[entryIndex];
+				const auto& result = results[entryIndex];
+				const auto statusName = GetFArcEntryVerifyStatusName(result.Status);
+
+				snprintf(formatBuffer, sizeof(formatBuffer), "    %-10.*s %016llX %-8s %10u  ", static_cast<int>(statusName.size()), statusName.data(),
+					static_cast<unsigned long long>(result.ContentHash), result.HasContentChecksum ? "checksum" : "-", entry.UncompressedSize);
+				outString.append(formatBuffer).append(entry.FileName).push_back('\n');
 			}
-			else if (entry.Flags.ZStdCompressed)
+		}
+		else if (format == FArcReportFormat::Json)
+		{
+			outString.append(isFirstArchive ? "[\n" : ",\n").append("  { \"archive\": ");
+			PeepoHappy::JSON::AppendEscapedString(outString, farcPath);
+			outString.append(", \"entries\": [");
+
+			for (size_t entryIndex = 0; entryIndex < inFArc.Entries.size(); entryIndex++)
 			{
-				const size_t decompressResult = PeepoHappy::Compression::Decompress(PeepoHappy::Compression::Method::ZStd,
-					readHead, entry.CompressedSize, entry.DecompressedFileContent.get(), entry.UncompressedSize);
+				const auto& entry = inFArc.Entries[entryIndex];
+				const auto& result = results[entryIndex];
+
+				outString.append((entryIndex == 0) ? "\n    { \"name\": " : ",\n    { \"name\": ");
+				PeepoHappy::JSON::AppendEscapedString(outString, entry.FileName);
+				outString.append(", \"status\": ");
+				PeepoHappy::JSON::AppendEscapedString(outString, GetFArcEntryVerifyStatusName(result.Status));
+				snprintf(formatBuffer, sizeof(formatBuffer), ", \"uncompressed_size\": %u, \"content_checksum\": %s, \"xxh3\": \"%016llX\" }",
+					entry.UncompressedSize, result.HasContentChecksum ? "true" : "false", static_cast<unsigned long long>(result.ContentHash));
+				outString.append(formatBuffer);
 			}
-			else
+
+			outString.append(inFArc.Entries.empty() ? "] }" : "\n  ] }");
+		}
+		else if (format == FArcReportFormat::Csv)
+		{
+			if (isFirstArchive)
+				outString.append("archive,name,status,uncompressed_size,content_checksum,xxh3\n");
+
+			for (size_t entryIndex = 0; entryIndex < inFArc.Entries.size(); entryIndex++)
 			{
-				::memcpy(entry.DecompressedFileContent.get(), readHead, entry.UncompressedSize);
+				const auto& entry = inFArc.Entries[entryIndex];
+				const auto& result = results[entryIndex];
+
+				AppendCsvEscapedString(outString, farcPath);
+				outString.push_back(',');
+				AppendCsvEscapedString(outString, entry.FileName);
+				outString.push_back(',');
+				outString.append(GetFArcEntryVerifyStatusName(result.Status));
+				snprintf(formatBuffer, sizeof(formatBuffer), ",%u,%s,%016llX\n", entry.UncompressedSize, result.HasContentChecksum ? "true" : "false", static_cast<unsigned long long>(result.ContentHash));
+				outString.append(formatBuffer);
 			}
 		}
+	}
 
-		return true;
+	int RunVerification(const CommandLineOptions& options)
+	{
+		std::vector<std::string> farcPaths = options.IsBatch() ? GatherBatchFArcPaths(options) : std::vector<std::string> { std::string(options.InputFArcPath) };
+		if (farcPaths.empty())
+		{
+			fprintf(stderr, "[ERROR] No input FArc files found\n");
+			return EXIT_WIDEPEEPOSAD;
+		}
+
+		std::unique_ptr<PeepoHappy::Threading::ThreadPool> threadPool;
+		if (options.JobCount > 1)
+			threadPool = std::make_unique<PeepoHappy::Threading::ThreadPool>(options.JobCount);
+
+		size_t failedArchiveCount = 0, verifiedEntryCount = 0, failedEntryCount = 0;
+		bool isFirstArchive = true;
+		std::string report;
+
+		for (const auto& farcPath : farcPaths)
+		{
+			auto farc = OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy, options.UseEntryIndexCache);
+			if (!farc.File.IsOpen() || farc.Signature == FArcSignature::Invalid)
+			{
+				fprintf(stderr, "[ERROR] Failed to verify '%s'\n", farcPath.c_str());
+				failedArchiveCount++;
+				continue;
+			}
+
+			FilterFArcEntries(farc, options.IncludePatterns, options.ExcludePatterns);
+			const auto results = VerifyFArcEntries(farc, threadPool.get());
+
+			for (const auto& result : results)
+				failedEntryCount += (result.Status != FArcEntryVerifyStatus::Ok);
+			verifiedEntryCount += results.size();
+
+			report.clear();
+			AppendFArcVerifyReport(report, farcPath, farc, results, options.ReportFormat, isFirstArchive);
+			fwrite(report.data(), sizeof(char), report.size(), stdout);
+			isFirstArchive = false;
+		}
+
+		if (options.ReportFormat == FArcReportFormat::Json)
+			fputs(isFirstArchive ? "[]\n" : "\n]\n", stdout);
+
+		fprintf(stderr, "Verified %zu entries, %zu failed\n", verifiedEntryCount, failedEntryCount);
+		return (failedArchiveCount == 0 && failedEntryCount == 0) ? EXIT_WIDEPEEPOHAPPY : EXIT_WIDEPEEPOSAD;
 	}
 
-	bool ExtractWriteAllFArcEntriesIntoDirectory(const FArc& inFArc, std::string_view outputDirectory)
+	// NOTE: Entries are compressed in parallel but written strictly in order by a single writer thread,
+	//		 with --max-memory bounding how many bytes may be waiting to be written at once
+	int RunPacking(const CommandLineOptions& options)
 	{
-		if (inFArc.FileContent == nullptr || inFArc.Signature == FArcSignature::Invalid)
-			return false;
+		const auto inputDirectory = PeepoHappy::ASCII::StripSuffix(PeepoHappy::ASCII::StripSuffix(options.PackDirectory, "/"), "\\");
+		if (!PeepoHappy::IO::DirectoryExists(inputDirectory))
+		{
+			fprintf(stderr, "[ERROR] Input directory '%.*s' not found\n", static_cast<int>(inputDirectory.size()), inputDirectory.data());
+			return EXIT_WIDEPEEPOSAD;
+		}
+
+		FArcBuildSettings buildSettings = options.PackSettings;
+		buildSettings.JobCount = options.JobCount;
+		if (options.MaxMemoryBytes != 0)
+			buildSettings.MaxInFlightBytes = options.MaxMemoryBytes;
 
-		PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+		FArcBuilder builder(buildSettings);
+		builder.AddDirectory(inputDirectory);
 
-		char outputPathBuffer[2048] = {};
-		::memcpy(outputPathBuffer, outputDirectory.data(), outputDirectory.size());
-		outputPathBuffer[outputDirectory.size()] = '/';
+		if (builder.GetEntryCount() == 0)
+		{
+			fprintf(stderr, "[ERROR] No input files found inside '%.*s'\n", static_cast<int>(inputDirectory.size()), inputDirectory.data());
+			return EXIT_WIDEPEEPOSAD;
+		}
 
-		char* pathBufferFileName = &outputPathBuffer[outputDirectory.size() + 1];
+		if (!builder.Build(options.InputFArcPath))
+		{
+			fprintf(stderr, "[ERROR] Failed to pack output FArc file\n");
+			return EXIT_WIDEPEEPOSAD;
+		}
 
-		for (const auto& entry : inFArc.Entries)
+		return EXIT_WIDEPEEPOHAPPY;
+	}
+
+	int RunReplacement(const CommandLineOptions& options)
+	{
+		std::vector<FArcEntryReplacement> replacements;
+		for (const auto filePath : options.ReplaceFilePaths)
 		{
-			if (entry.FileName.empty() || entry.DecompressedFileContent == nullptr)
+			if (!PeepoHappy::IO::FileExists(filePath))
 			{
-				fprintf(stderr, "[ERROR] Unable to extract file[%zu]\n", static_cast<size_t>(std::distance(&inFArc.Entries.front(), &entry)));
-				continue;
+				fprintf(stderr, "[ERROR] Replacement file '%.*s' not found\n", static_cast<int>(filePath.size()), filePath.data());
+				return EXIT_WIDEPEEPOSAD;
 			}
 
-			::memcpy(pathBufferFileName, entry.FileName.data(), entry.FileName.size() + 1);
-			PeepoHappy::IO::WriteEntireFile(outputPathBuffer, entry.DecompressedFileContent.get(), entry.UncompressedSize);
+			replacements.push_back({ std::string(PeepoHappy::Path::GetFileName(filePath)), MakeFileEntrySource(filePath) });
+		}
+
+		FArcUpdateSettings updateSettings = {};
+		updateSettings.CompressionLevel = options.PackSettings.CompressionLevel;
+
+		if (!ReplaceFArcEntriesInPlace(options.InputFArcPath, replacements, updateSettings))
+		{
+			fprintf(stderr, "[ERROR] Failed to replace entries of '%.*s'\n", static_cast<int>(options.InputFArcPath.size()), options.InputFArcPath.data());
+			return EXIT_WIDEPEEPOSAD;
 		}
 
+		return EXIT_WIDEPEEPOHAPPY;
+	}
+
+	// NOTE: Removes every entry left unchanged since the previous extraction into the output directory and prints how many were skipped
+	void RemoveUnchangedEntriesForIncrementalExtraction(FArc& inOutFArc, std::string_view outputDirectory, FArcExtractionManifest& outManifest, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		const size_t totalEntryCount = inOutFArc.Entries.size();
+		LoadFArcExtractionManifest(outputDirectory, outManifest);
+
+		const size_t unchangedEntryCount = RemoveUnchangedFArcEntries(inOutFArc, outputDirectory, outManifest, threadPool);
+		printf("Skipped %zu of %zu entries unchanged since the last extraction into '%.*s'\n", unchangedEntryCount, totalEntryCount, static_cast<int>(outputDirectory.size()), outputDirectory.data());
+	}
+
+	// NOTE: Only called once all remaining entries have been extracted successfully, otherwise the previous manifest is kept as is
+	//		 which still lists the old compressed data of any changed entries so that they are extracted again by the next run
+	bool FinishIncrementalExtraction(std::string_view outputDirectory, const FArcExtractionManifest& manifest)
+	{
+		if (!WriteFArcExtractionManifest(outputDirectory, manifest))
+		{
+			fprintf(stderr, "[ERROR] Failed to write extraction manifest for '%.*s'\n", static_cast<int>(outputDirectory.size()), outputDirectory.data());
+			return false;
+		}
 		return true;
 	}
 
+	int RunBatchExtraction(const CommandLineOptions& options, PeepoHappy::IO::ContentAddressedStore* contentStore)
+	{
+		const auto farcPaths = GatherBatchFArcPaths(options);
+		if (farcPaths.empty())
+		{
+			fprintf(stderr, "[ERROR] No input FArc files found\n");
+			return EXIT_WIDEPEEPOSAD;
+		}
+
+		PeepoHappy::Threading::ThreadPool threadPool(options.JobCount);
+		PeepoHappy::Threading::TaskGroup archiveTaskGroup;
+
+		// NOTE: Used as a plain counting semaphore limiting the number of archives held open at once to one per thread
+		PeepoHappy::Threading::ByteBudget openArchiveSlots(threadPool.GetThreadCount());
+		std::atomic<size_t> failedArchiveCount = 0;
+
+		for (const auto& farcPath : farcPaths)
+		{
+			openArchiveSlots.Acquire(1);
+			threadPool.Enqueue(archiveTaskGroup, [&, farcPath = std::string_view(farcPath)]
+			{
+				auto farc = OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy, options.UseEntryIndexCache);
+				FilterFArcEntries(farc, options.IncludePatterns, options.ExcludePatterns);
+
+				const auto outputDirectory = PeepoHappy::Path::TrimFileExtension(farcPath);
+
+				FArcExtractionManifest manifest;
+				if (options.Incremental)
+					RemoveUnchangedEntriesForIncrementalExtraction(farc, outputDirectory, manifest, &threadPool);
+
+				bool wasSuccessful = options.DirectWrite ?
+					ExtractAllFArcEntriesDirectIntoDirectory(farc, outputDirectory, &threadPool) :
+					(ReadAndDecompressAllFArcEntries(farc, threadPool) && ExtractWriteAllFArcEntriesIntoDirectory(farc, outputDirectory, &threadPool, contentStore));
+
+				if (wasSuccessful && options.Incremental)
+					wasSuccessful = FinishIncrementalExtraction(outputDirectory, manifest);
+
+				if (!wasSuccessful)
+				{
+					fprintf(stderr, "[ERROR] Failed to extract '%.*s'\n", static_cast<int>(farcPath.size()), farcPath.data());
+					failedArchiveCount++;
+				}
+
+				openArchiveSlots.Release(1);
+			});
+		}
+
+		threadPool.Wait(archiveTaskGroup);
+		return (failedArchiveCount == 0) ? EXIT_WIDEPEEPOHAPPY : EXIT_WIDEPEEPOSAD;
+	}
+
 	int EntryPoint()
 	{
 		const auto[argc, argv] = PeepoHappy::UTF8::GetCommandLineArguments();
 
-		if (argc < 2)
+		CommandLineOptions options = {};
+		if (argc < 2 || !ParseCommandLineOptions(argc, argv, options))
 		{
 			printf("Description:\n");
 			printf("    A program to extract compressed/encrypted files stored within modern FArc files\n");
 			printf("    used by Fate Grand Order Arcade\n");
 			printf("\n");
 			printf("Usage:\n");
-			printf("    FgoFArcExtractor.exe \"{input_farc_file}.farc\"\n");
+			printf("    FgoFArcExtractor.exe [options] \"{input_farc_file}.farc\"\n");
+			printf("    FgoFArcExtractor.exe [options] --batch \"{input_directory}\" @\"{input_list_file}.txt\"\n");
+			printf("    FgoFArcExtractor.exe [options] --pack \"{input_directory}\" \"{output_farc_file}.farc\"\n");
+			printf("    FgoFArcExtractor.exe [options] --replace \"{input_file}\" \"{farc_file}.farc\"\n");
+			printf("\n");
+			printf("Options:\n");
+			printf("    -j, --jobs {count}    Decrypt and decompress using {count} worker threads (0 = one per hardware thread)\n");
+			printf("    -x, --extract {name}  Only extract the single entry named {name}\n");
+			printf("    -l, --list            Print the entries of the input FArc files instead of extracting them\n");
+			printf("    --verify              Decompress and checksum every entry without writing anything, printing a per entry report\n");
+			printf("    --format {format}     Output format used by --list and --verify, either text (default), json or csv\n");
+			printf("    --include {glob}      Only extract entries matching the case insensitive {glob} pattern, may be repeated\n");
+			printf("    --exclude {glob}      Skip entries matching the case insensitive {glob} pattern, may be repeated\n");
+			printf("    --pipeline            Overlap reading, decompressing and writing of entries with bounded memory use\n");
+			printf("    --max-memory {size}   Limit in-flight entry data to {size} bytes (K/M/G suffixes allowed), implies --pipeline\n");
+			printf("    --direct              Decompress straight into memory mapped output files instead of intermediate buffers\n");
+			printf("    --index-cache         Reuse (or create) a \"{input_farc_file}.farc.fidx\" entry index next to the input instead of parsing its entry table\n");
+			printf("    --dedup-store {dir}   Store every distinct file content only once inside {dir} and hardlink all output files of the same content to it\n");
+			printf("    --incremental         Skip entries whose compressed data is unchanged since the last extraction, tracked by a \"{output_directory}.fman\" manifest\n");
+			printf("    --trace {json_file}   Record per thread timings of every stage into a Chrome trace file and print a throughput summary\n");
+			printf("    --batch {directory}   Extract every .farc file inside {directory} sharing a single pool of worker threads, may be repeated\n");
+			printf("    @{list_file}          Extract every .farc file listed in {list_file} (one path per line) as part of the same batch\n");
+			printf("\n");
+			printf("Pack Options:\n");
+			printf("    --pack {directory}    Build a new FArc file from every file inside {directory}, compressing them using the -j worker threads\n");
+			printf("    --method {method}     Compression method of the packed entries, either gzip (default), zstd or none\n");
+			printf("    --level {level}       Compression level, 0 to 9 for gzip (default 6) and 1 to 22 for zstd (default 3)\n");
+			printf("    --split-chunks {size} Compress entries as independent chunks of {size} bytes (K/M/G suffixes allowed)\n");
+			printf("    --encrypt             Encrypt the packed FArc file\n");
+			printf("    --signature {sig}     Output signature, either FArC, FARC (default) or FARc\n");
+			printf("    --alignment {count}   Align every entry to a multiple of {count} bytes (default 16)\n");
+			printf("\n");
+			printf("Replace Options:\n");
+			printf("    --replace {file}      Replace the entry named after {file} in place, only rewriting its data and its entry table fields, may be repeated\n");
+			printf("    --level {level}       Compression level 1 to 9 used for the replaced entries, which keep their compression method\n");
 			printf("\n");
 			printf("Notes:\n");
 			printf("    Output files are written into a same directory sub directory named after the input FArc file.\n");
+			printf("    Output files deduplicated using --dedup-store share their data on disk, editing one of them in place edits all of them.\n");
 			printf("\n");
 			printf("Credits:\n");
 			printf("    Programmed and reverse engineered by samyuu\n");
@@ -335,22 +981,152 @@ namespace FArcExtractor
 			return EXIT_WIDEPEEPOSAD;
 		}
 
-		const auto inputFArcPath = std::string_view(argv[1]);
+		// NOTE: Declared before any of the thread pools below so all of their threads have finished by the time the trace is written
+		struct TraceOutputScope
+		{
+			std::string_view FilePath;
+			~TraceOutputScope()
+			{
+				if (FilePath.empty())
+					return;
+
+				if (!PeepoHappy::Trace::WriteChromeTraceJson(FilePath))
+					fprintf(stderr, "[ERROR] Failed to write trace file '%.*s'\n", static_cast<int>(FilePath.size()), FilePath.data());
+				PeepoHappy::Trace::PrintThroughputSummary();
+			}
+		} traceOutputScope = { options.TraceOutputPath };
+
+		if (!options.TraceOutputPath.empty())
+			PeepoHappy::Trace::Enable();
+
+		if (options.ListEntries)
+			return RunListing(options);
+
+		if (options.VerifyEntries)
+			return RunVerification(options);
+
+		if (!options.PackDirectory.empty())
+			return RunPacking(options);
+
+		if (!options.ReplaceFilePaths.empty())
+			return RunReplacement(options);
+
+		std::unique_ptr<PeepoHappy::IO::ContentAddressedStore> contentStore;
+		if (!options.DedupStoreDirectory.empty())
+			contentStore = std::make_unique<PeepoHappy::IO::ContentAddressedStore>(options.DedupStoreDirectory);
+
+		// NOTE: Declared after the content store so its summary is printed once the extraction has finished, regardless of the exit path taken
+		struct DeduplicationSummaryScope
+		{
+			const PeepoHappy::IO::ContentAddressedStore* ContentStore;
+			~DeduplicationSummaryScope()
+			{
+				if (ContentStore == nullptr)
+					return;
+
+				printf("Deduplicated %zu files (%.2f MB), wrote %zu new blobs\n", ContentStore->GetDeduplicatedFileCount(),
+					static_cast<double>(ContentStore->GetDeduplicatedByteCount()) / (1024.0 * 1024.0), ContentStore->GetWrittenBlobCount());
+			}
+		} deduplicationSummaryScope = { contentStore.get() };
+
+		if (options.IsBatch())
+			return RunBatchExtraction(options, contentStore.get());
+
+		const auto inputFArcPath = options.InputFArcPath;
 		const auto outputDirectory = PeepoHappy::Path::TrimFileExtension(inputFArcPath);
 
-		auto farc = OpenReadDecryptAndParseFArcEntries(inputFArcPath);
-		if (!ReadAndDecompressAllFArcEntries(farc))
+		if (!options.ExtractFileName.empty())
 		{
-			fprintf(stderr, "[ERROR] Failed to parse file entries\n");
-			return EXIT_WIDEPEEPOSAD;
+			auto farc = OpenReadDecryptAndParseFArcEntries(inputFArcPath, nullptr, FArcDecryptMode::Lazy, options.UseEntryIndexCache);
+
+			auto* entry = farc.FindEntry(options.ExtractFileName);
+			if (entry == nullptr)
+			{
+				fprintf(stderr, "[ERROR] No entry named '%.*s' found\n", static_cast<int>(options.ExtractFileName.size()), options.ExtractFileName.data());
+				return EXIT_WIDEPEEPOSAD;
+			}
+
+			std::unique_ptr<PeepoHappy::Threading::ThreadPool> threadPool;
+			if (options.JobCount > 1)
+				threadPool = std::make_unique<PeepoHappy::Threading::ThreadPool>(options.JobCount);
+
+			bool wasSuccessful;
+			if (options.DirectWrite)
+			{
+				PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+				wasSuccessful = ExtractFArcEntryDirectIntoDirectory(farc, *entry, outputDirectory, threadPool.get());
+			}
+			else
+			{
+				ReadAndDecompressFArcEntry(farc, *entry, threadPool.get());
+				PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+				wasSuccessful = ExtractWriteFArcEntryIntoDirectory(*entry, outputDirectory, contentStore.get());
+			}
+
+			if (!wasSuccessful)
+			{
+				fprintf(stderr, "[ERROR] Failed to extract output file\n");
+				return EXIT_WIDEPEEPOSAD;
+			}
+
+			return EXIT_WIDEPEEPOHAPPY;
 		}
 
-		if (!ExtractWriteAllFArcEntriesIntoDirectory(farc, outputDirectory))
+		// NOTE: When only a subset of entries is going to be extracted there's no point in decrypting the rest of the archive
+		const bool isFiltered = (!options.IncludePatterns.empty() || !options.ExcludePatterns.empty());
+
+		// NOTE: The pipeline decrypts entries as part of its read stage rather than up front to overlap it with the other stages
+		//		 while the entry index cache is only of any use if the entry table doesn't have to be decrypted anyway
+		const bool decryptLazily = (isFiltered || options.Pipelined || options.UseEntryIndexCache);
+
+		// NOTE: Shared by the up front decryption, the incremental hashing and the extraction itself, the pipeline instead runs its own threads
+		std::unique_ptr<PeepoHappy::Threading::ThreadPool> threadPool;
+		if (options.JobCount > 1 && (!options.Pipelined || options.Incremental))
+			threadPool = std::make_unique<PeepoHappy::Threading::ThreadPool>(options.JobCount);
+
+		auto farc = OpenReadDecryptAndParseFArcEntries(inputFArcPath, threadPool.get(), decryptLazily ? FArcDecryptMode::Lazy : FArcDecryptMode::Eager, options.UseEntryIndexCache);
+		FilterFArcEntries(farc, options.IncludePatterns, options.ExcludePatterns);
+
+		FArcExtractionManifest manifest;
+		if (options.Incremental)
+			RemoveUnchangedEntriesForIncrementalExtraction(farc, outputDirectory, manifest, threadPool.get());
+
+		bool wasSuccessful;
+		if (options.Pipelined)
+		{
+			FArcPipelineSettings pipelineSettings = {};
+			pipelineSettings.DecompressJobCount = options.JobCount;
+			pipelineSettings.ContentStore = contentStore.get();
+			if (options.MaxMemoryBytes != 0)
+				pipelineSettings.MaxInFlightBytes = options.MaxMemoryBytes;
+
+			wasSuccessful = ExtractFArcEntriesPipelined(farc, outputDirectory, pipelineSettings);
+		}
+		else if (options.DirectWrite)
+		{
+			wasSuccessful = ExtractAllFArcEntriesDirectIntoDirectory(farc, outputDirectory, threadPool.get());
+		}
+		else
+		{
+			if (!(threadPool != nullptr ? ReadAndDecompressAllFArcEntries(farc, *threadPool) : ReadAndDecompressAllFArcEntries(farc)))
+			{
+				fprintf(stderr, "[ERROR] Failed to decompress file entries\n");
+				return EXIT_WIDEPEEPOSAD;
+			}
+
+			wasSuccessful = ExtractWriteAllFArcEntriesIntoDirectory(farc, outputDirectory, threadPool.get(), contentStore.get());
+		}
+
+		if (!wasSuccessful)
 		{
 			fprintf(stderr, "[ERROR] Failed to extract output files\n");
 			return EXIT_WIDEPEEPOSAD;
 		}
 
+		// NOTE: Every extraction mode above reports failure if any single entry failed, so the manifest never records an entry that wasn't extracted
+		if (options.Incremental && !FinishIncrementalExtraction(outputDirectory, manifest))
+			return EXIT_WIDEPEEPOSAD;
+
 		return EXIT_WIDEPEEPOHAPPY;
 	}
 }
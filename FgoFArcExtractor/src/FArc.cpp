@@ -0,0 +1,1039 @@
+#include "FArc.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace FArcExtractor
+{
+	void RebuildFArcEntryNameIndex(FArc& inOutFArc)
+	{
+		inOutFArc.EntryNameIndex.clear();
+		inOutFArc.EntryNameIndex.reserve(inOutFArc.Entries.size());
+		for (size_t i = 0; i < inOutFArc.Entries.size(); i++)
+			inOutFArc.EntryNameIndex.emplace(inOutFArc.Entries[i].FileName, i);
+	}
+
+	// NOTE: Makes a FArc whose entry table couldn't be parsed in full fail just like one with an invalid header
+	//		 instead of leaving a partial list of entries behind that would otherwise be treated as the complete archive
+	void InvalidateFArcEntries(FArc& outFArc)
+	{
+		outFArc.Signature = FArcSignature::Invalid;
+		outFArc.Entries.clear();
+		outFArc.EntryNameIndex.clear();
+	}
+
+	bool ParseFArcEntryTable(const u8* tableData, size_t tableSize, FArc& outFArc)
+	{
+		PeepoHappy::Trace::ScopedEvent parseEvent("parse", 0, "entry_table");
+
+		const u8* readHead = tableData;
+		const u8* const tableEnd = (tableData + tableSize);
+		auto canRead = [&](size_t byteSize) { return (static_cast<size_t>(tableEnd - readHead) >= byteSize); };
+
+		if (!canRead(sizeof(u32) * 4))
+			return false;
+
+		const u32 maybeAlignmentA = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+		const u32 unkEither1Or4 = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+		const u32 fileCount = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+		const u32 maybeAlignmentB = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+
+		constexpr size_t minEntrySize = sizeof('\0') + (sizeof(u32) * 4);
+
+		outFArc.Entries.clear();
+		outFArc.Entries.reserve(std::min<size_t>(fileCount, tableSize / minEntrySize));
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			const u8* fileNameEnd = static_cast<const u8*>(::memchr(readHead, '\0', static_cast<size_t>(tableEnd - readHead)));
+			if (fileNameEnd == nullptr || !canRead(static_cast<size_t>(fileNameEnd - readHead) + minEntrySize))
+			{
+				outFArc.Entries.clear();
+				outFArc.EntryNameIndex.clear();
+				return false;
+			}
+
+			auto& entry = outFArc.Entries.emplace_back();
+			entry.FileName = std::string_view(reinterpret_cast<const char*>(readHead)); readHead += entry.FileName.size() + sizeof('\0');
+			entry.Offset = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+			entry.CompressedSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+			entry.UncompressedSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+			const u32 fileFlags = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+			entry.Flags = *reinterpret_cast<const FArcFileFlags*>(&fileFlags);
+
+			if (outFArc.Flags.Encrypted)
+				entry.Offset += static_cast<u32>(PeepoHappy::Crypto::Aes128KeySize);
+		}
+
+		outFArc.EntryTableSize = static_cast<size_t>(readHead - tableData);
+		RebuildFArcEntryNameIndex(outFArc);
+		parseEvent.SetByteCount(outFArc.EntryTableSize);
+		return true;
+	}
+
+	// NOTE: Byte offset within the file at which the (possibly encrypted and block padded) entry table ends
+	size_t GetFArcEntryTableFileEnd(const FArc& inFArc)
+	{
+		return inFArc.Flags.Encrypted ?
+			(FArcEncryptedDataOffset + PeepoHappy::Crypto::Align(inFArc.EntryTableSize, PeepoHappy::Crypto::Aes128Alignment)) :
+			(FArcUnencryptedHeaderSize + inFArc.EntryTableSize);
+	}
+
+	// NOTE: The entry index cache is a sidecar file stored next to the archive containing its already parsed (and decrypted) entry table.
+	//		 It is keyed by the archive file size, its last write time and a hash of the raw header and entry table bytes,
+	//		 so an archive opened through it doesn't have to have its entry table decrypted or parsed at all
+	constexpr std::string_view FArcEntryIndexFileExtension = ".fidx";
+	constexpr u32 FArcEntryIndexMagic = 'FIDX';
+	constexpr u32 FArcEntryIndexVersion = 1;
+
+	struct FArcEntryIndexHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u64 ArchiveFileSize;
+		u64 ArchiveLastWriteTime;
+		u64 ArchiveEntryTableFileEnd;
+		u64 ArchiveEntryTableHash;
+		u32 ArchiveSignature;
+		u32 ArchiveFlags;
+		u64 ArchiveEntryTableSize;
+		u32 EntryCount;
+		u32 EntryDataSize;
+		u64 EntryDataHash;
+	};
+
+	struct FArcEntryIndexEntry
+	{
+		u32 Offset;
+		u32 CompressedSize;
+		u32 UncompressedSize;
+		u32 Flags;
+		u32 FileNameLength;
+	};
+
+	std::string GetFArcEntryIndexPath(std::string_view inputFArcPath)
+	{
+		return std::string(inputFArcPath).append(FArcEntryIndexFileExtension);
+	}
+
+	bool TryLoadFArcEntryIndex(std::string_view inputFArcPath, FArc& inOutFArc)
+	{
+		auto[indexContent, indexSize] = PeepoHappy::IO::ReadEntireFile(GetFArcEntryIndexPath(inputFArcPath));
+		if (indexContent == nullptr || indexSize < sizeof(FArcEntryIndexHeader))
+			return false;
+
+		FArcEntryIndexHeader header;
+		::memcpy(&header, indexContent.get(), sizeof(header));
+
+		const u8* const entryData = (indexContent.get() + sizeof(header));
+		if (header.Magic != FArcEntryIndexMagic || header.Version != FArcEntryIndexVersion || header.EntryDataSize != (indexSize - sizeof(header)))
+			return false;
+
+		if (header.ArchiveFileSize != inOutFArc.File.Size() || header.ArchiveLastWriteTime != PeepoHappy::IO::GetFileLastWriteTime(inputFArcPath) || header.ArchiveEntryTableFileEnd > inOutFArc.File.Size())
+			return false;
+
+		if (header.EntryDataHash != PeepoHappy::Hash::ComputeXXH64(entryData, header.EntryDataSize))
+			return false;
+
+		// NOTE: The hash covers the still encrypted entry table so this has to happen before any part of the mapping gets decrypted in place
+		if (header.ArchiveEntryTableHash != PeepoHappy::Hash::ComputeXXH64(inOutFArc.File.Data(), static_cast<size_t>(header.ArchiveEntryTableFileEnd)))
+			return false;
+
+		std::vector<FArcFileEntry> entries;
+		entries.reserve(header.EntryCount);
+
+		const u8* readHead = entryData;
+		const u8* const entryDataEnd = (entryData + header.EntryDataSize);
+		for (u32 i = 0; i < header.EntryCount; i++)
+		{
+			FArcEntryIndexEntry indexEntry;
+			if (static_cast<size_t>(entryDataEnd - readHead) < sizeof(indexEntry))
+				return false;
+
+			::memcpy(&indexEntry, readHead, sizeof(indexEntry)); readHead += sizeof(indexEntry);
+			if (static_cast<size_t>(entryDataEnd - readHead) < (indexEntry.FileNameLength + sizeof('\0')) || readHead[indexEntry.FileNameLength] != '\0')
+				return false;
+
+			auto& entry = entries.emplace_back();
+			entry.FileName = std::string_view(reinterpret_cast<const char*>(readHead), indexEntry.FileNameLength); readHead += indexEntry.FileNameLength + sizeof('\0');
+			entry.Offset = indexEntry.Offset;
+			entry.CompressedSize = indexEntry.CompressedSize;
+			entry.UncompressedSize = indexEntry.UncompressedSize;
+			entry.Flags = *reinterpret_cast<const FArcFileFlags*>(&indexEntry.Flags);
+		}
+
+		inOutFArc.Signature = static_cast<FArcSignature>(header.ArchiveSignature);
+		inOutFArc.Flags = *reinterpret_cast<const FArcFlags*>(&header.ArchiveFlags);
+		inOutFArc.EntryTableSize = static_cast<size_t>(header.ArchiveEntryTableSize);
+		inOutFArc.EntryDataEncrypted = inOutFArc.Flags.Encrypted;
+		inOutFArc.DecryptedEntryTable = std::move(indexContent);
+		inOutFArc.Entries = std::move(entries);
+		RebuildFArcEntryNameIndex(inOutFArc);
+		return true;
+	}
+
+	// NOTE: Must be called while the entry table inside the mapping is still in its original encrypted form
+	bool WriteFArcEntryIndex(std::string_view inputFArcPath, const FArc& inFArc)
+	{
+		const size_t entryTableFileEnd = GetFArcEntryTableFileEnd(inFArc);
+		if (!inFArc.File.IsOpen() || entryTableFileEnd > inFArc.File.Size())
+			return false;
+
+		std::vector<u8> entryData;
+		for (const auto& entry : inFArc.Entries)
+		{
+			FArcEntryIndexEntry indexEntry;
+			indexEntry.Offset = entry.Offset;
+			indexEntry.CompressedSize = entry.CompressedSize;
+			indexEntry.UncompressedSize = entry.UncompressedSize;
+			indexEntry.Flags = *reinterpret_cast<const u32*>(&entry.Flags);
+			indexEntry.FileNameLength = static_cast<u32>(entry.FileName.size());
+
+			const auto* indexEntryBytes = reinterpret_cast<const u8*>(&indexEntry);
+			entryData.insert(entryData.end(), indexEntryBytes, indexEntryBytes + sizeof(indexEntry));
+			entryData.insert(entryData.end(), entry.FileName.begin(), entry.FileName.end());
+			entryData.push_back('\0');
+		}
+
+		FArcEntryIndexHeader header = {};
+		header.Magic = FArcEntryIndexMagic;
+		header.Version = FArcEntryIndexVersion;
+		header.ArchiveFileSize = inFArc.File.Size();
+		header.ArchiveLastWriteTime = PeepoHappy::IO::GetFileLastWriteTime(inputFArcPath);
+		header.ArchiveEntryTableFileEnd = entryTableFileEnd;
+		header.ArchiveEntryTableHash = PeepoHappy::Hash::ComputeXXH64(inFArc.File.Data(), entryTableFileEnd);
+		header.ArchiveSignature = static_cast<u32>(inFArc.Signature);
+		header.ArchiveFlags = *reinterpret_cast<const u32*>(&inFArc.Flags);
+		header.ArchiveEntryTableSize = inFArc.EntryTableSize;
+		header.EntryCount = static_cast<u32>(inFArc.Entries.size());
+		header.EntryDataSize = static_cast<u32>(entryData.size());
+		header.EntryDataHash = PeepoHappy::Hash::ComputeXXH64(entryData.data(), entryData.size());
+
+		std::vector<u8> indexContent(sizeof(header) + entryData.size());
+		::memcpy(indexContent.data(), &header, sizeof(header));
+		if (!entryData.empty())
+			::memcpy(indexContent.data() + sizeof(header), entryData.data(), entryData.size());
+
+		return PeepoHappy::IO::WriteEntireFile(GetFArcEntryIndexPath(inputFArcPath), indexContent.data(), indexContent.size());
+	}
+
+	FArc OpenReadDecryptAndParseFArcEntries(std::string_view inputFArcPath, PeepoHappy::Threading::ThreadPool* threadPool, FArcDecryptMode decryptMode, bool useEntryIndexCache)
+	{
+		FArc outFArc = {};
+
+		PeepoHappy::Trace::ScopedEvent openEvent("read", 0, "open", inputFArcPath);
+		if (!outFArc.File.Open(inputFArcPath) || outFArc.File.Size() < FArcUnencryptedHeaderSize)
+		{
+			fprintf(stderr, "[ERROR] Unable to open input FArc file\n");
+			return outFArc;
+		}
+
+		u8* const fileContent = outFArc.File.Data();
+		const u8* readHead = fileContent;
+		const u32 signature = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+
+		outFArc.Signature = (signature == 'FArC') ? FArcSignature::FArC : (signature == 'FARC') ? FArcSignature::FARC : (signature == 'FARc') ? FArcSignature::FARc : FArcSignature::Invalid;
+		if (outFArc.Signature == FArcSignature::Invalid)
+		{
+			fprintf(stderr, "[ERROR] Unexpected FArc signature!\n");
+			return outFArc;
+		}
+
+		const u32 headerSize = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+		const u32 farcFlags = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+		const u32 unkAlways0 = ByteSwapU32(*reinterpret_cast<const u32*>(readHead)); readHead += sizeof(u32);
+
+		outFArc.Flags = *reinterpret_cast<const FArcFlags*>(&farcFlags);
+
+		openEvent.SetByteCount(FArcUnencryptedHeaderSize);
+
+		useEntryIndexCache &= (decryptMode == FArcDecryptMode::Lazy || !outFArc.Flags.Encrypted);
+		if (useEntryIndexCache)
+		{
+			PeepoHappy::Trace::ScopedEvent indexEvent("parse", 0, "index_cache");
+			if (TryLoadFArcEntryIndex(inputFArcPath, outFArc))
+				return outFArc;
+		}
+
+		if (!outFArc.Flags.Encrypted)
+		{
+			if (!ParseFArcEntryTable(fileContent + FArcUnencryptedHeaderSize, outFArc.File.Size() - FArcUnencryptedHeaderSize, outFArc))
+			{
+				fprintf(stderr, "[ERROR] Truncated FArc entry table!\n");
+				InvalidateFArcEntries(outFArc);
+			}
+			else if (useEntryIndexCache)
+				WriteFArcEntryIndex(inputFArcPath, outFArc);
+			return outFArc;
+		}
+
+		if (outFArc.File.Size() < FArcEncryptedDataOffset)
+		{
+			fprintf(stderr, "[ERROR] Truncated encrypted FArc header!\n");
+			InvalidateFArcEntries(outFArc);
+			return outFArc;
+		}
+
+		const auto key = PeepoHappy::Crypto::ParseAes128KeyHexByteString(FArcAes128KeyHexString);
+
+		PeepoHappy::Crypto::Aes128IVBytes iv = {};
+		::memcpy(iv.data(), fileContent + FArcUnencryptedHeaderSize, sizeof(iv));
+
+		u8* const encryptedData = (fileContent + FArcEncryptedDataOffset);
+		const size_t encryptedDataSize = (outFArc.File.Size() - FArcEncryptedDataOffset) & ~(PeepoHappy::Crypto::Aes128Alignment - 1);
+
+		if (decryptMode == FArcDecryptMode::Eager)
+		{
+			PeepoHappy::Trace::ScopedEvent decryptEvent("decrypt", encryptedDataSize, "archive");
+			const bool decryptionSuccessful = (threadPool != nullptr) ?
+				PeepoHappy::Crypto::DecryptAes128Cbc(encryptedData, encryptedData, encryptedDataSize, key, iv, *threadPool) :
+				PeepoHappy::Crypto::DecryptAes128Cbc(encryptedData, encryptedData, encryptedDataSize, key, iv);
+
+			if (!decryptionSuccessful)
+			{
+				fprintf(stderr, "[ERROR] Failed to decrypt FArc!\n");
+				InvalidateFArcEntries(outFArc);
+				return outFArc;
+			}
+
+			if (!ParseFArcEntryTable(encryptedData, encryptedDataSize, outFArc))
+			{
+				fprintf(stderr, "[ERROR] Truncated FArc entry table!\n");
+				InvalidateFArcEntries(outFArc);
+			}
+			return outFArc;
+		}
+
+		// NOTE: The size of the entry table isn't stored anywhere so keep decrypting a larger prefix until it has been parsed in full.
+		//		 Everything past it is left encrypted inside the mapping, which also keeps the ciphertext around as IVs for the entries
+		constexpr size_t initialTableDecryptSize = (4 * 1024);
+		outFArc.EntryDataEncrypted = true;
+
+		size_t previousTableDecryptSize = 0;
+		for (size_t tableDecryptSize = std::min(initialTableDecryptSize, encryptedDataSize); ; tableDecryptSize = std::min(tableDecryptSize * 2, encryptedDataSize))
+		{
+			auto grownDecryptedEntryTable = std::unique_ptr<u8[]>(new u8[tableDecryptSize]);
+
+			// NOTE: Continue the CBC chain where the previous attempt left off so every block is only ever decrypted once
+			if (previousTableDecryptSize > 0)
+			{
+				::memcpy(grownDecryptedEntryTable.get(), outFArc.DecryptedEntryTable.get(), previousTableDecryptSize);
+				::memcpy(iv.data(), encryptedData + previousTableDecryptSize - sizeof(iv), sizeof(iv));
+			}
+
+			{
+				PeepoHappy::Trace::ScopedEvent decryptEvent("decrypt", tableDecryptSize - previousTableDecryptSize, "entry_table");
+				PeepoHappy::Crypto::DecryptAes128Cbc(encryptedData + previousTableDecryptSize, grownDecryptedEntryTable.get() + previousTableDecryptSize, tableDecryptSize - previousTableDecryptSize, key, iv);
+			}
+			outFArc.DecryptedEntryTable = std::move(grownDecryptedEntryTable);
+			previousTableDecryptSize = tableDecryptSize;
+
+			if (ParseFArcEntryTable(outFArc.DecryptedEntryTable.get(), tableDecryptSize, outFArc))
+			{
+				if (useEntryIndexCache)
+					WriteFArcEntryIndex(inputFArcPath, outFArc);
+				break;
+			}
+
+			if (tableDecryptSize >= encryptedDataSize)
+			{
+				fprintf(stderr, "[ERROR] Truncated FArc entry table!\n");
+				InvalidateFArcEntries(outFArc);
+				break;
+			}
+		}
+
+		return outFArc;
+	}
+
+	const u8* DecryptFArcEntryData(const FArc& inFArc, const FArcFileEntry& entry, std::vector<u8>& outDecryptedBuffer)
+	{
+		constexpr size_t blockSize = PeepoHappy::Crypto::Aes128Alignment;
+
+		// NOTE: Empty entries starting on a block boundary span zero blocks, there is nothing to decrypt but they are still perfectly valid
+		if (entry.CompressedSize == 0)
+			return (entry.Offset >= FArcEncryptedDataOffset) ? (inFArc.File.Data() + entry.Offset) : nullptr;
+
+		const size_t encryptedDataEnd = FArcEncryptedDataOffset + ((inFArc.File.Size() - FArcEncryptedDataOffset) & ~(blockSize - 1));
+		const size_t alignedStart = std::max(static_cast<size_t>(entry.Offset) & ~(blockSize - 1), FArcEncryptedDataOffset);
+		const size_t alignedEnd = std::min(PeepoHappy::Crypto::Align(static_cast<size_t>(entry.Offset) + entry.CompressedSize, blockSize), encryptedDataEnd);
+
+		if (entry.Offset < FArcEncryptedDataOffset || alignedEnd <= alignedStart || (static_cast<size_t>(entry.Offset) + entry.CompressedSize) > alignedEnd)
+			return nullptr;
+
+		PeepoHappy::Crypto::Aes128IVBytes iv = {};
+		::memcpy(iv.data(), inFArc.File.Data() + alignedStart - blockSize, sizeof(iv));
+
+		PeepoHappy::Trace::ScopedEvent decryptEvent("decrypt", alignedEnd - alignedStart, "entry", entry.FileName);
+		outDecryptedBuffer.resize(alignedEnd - alignedStart);
+		const auto key = PeepoHappy::Crypto::ParseAes128KeyHexByteString(FArcAes128KeyHexString);
+		PeepoHappy::Crypto::DecryptAes128Cbc(inFArc.File.Data() + alignedStart, outDecryptedBuffer.data(), outDecryptedBuffer.size(), key, iv);
+
+		return outDecryptedBuffer.data() + (entry.Offset - alignedStart);
+	}
+
+	void FilterFArcEntries(FArc& inOutFArc, const std::vector<std::string_view>& includePatterns, const std::vector<std::string_view>& excludePatterns)
+	{
+		if (includePatterns.empty() && excludePatterns.empty())
+			return;
+
+		auto matchesAnyPattern = [](std::string_view fileName, const std::vector<std::string_view>& patterns)
+		{
+			return std::any_of(patterns.begin(), patterns.end(), [&](std::string_view pattern) { return PeepoHappy::ASCII::MatchesGlobInsensitive(fileName, pattern); });
+		};
+
+		auto isFilteredOut = [&](const FArcFileEntry& entry)
+		{
+			if (!includePatterns.empty() && !matchesAnyPattern(entry.FileName, includePatterns))
+				return true;
+			return matchesAnyPattern(entry.FileName, excludePatterns);
+		};
+
+		inOutFArc.Entries.erase(std::remove_if(inOutFArc.Entries.begin(), inOutFArc.Entries.end(), isFilteredOut), inOutFArc.Entries.end());
+		RebuildFArcEntryNameIndex(inOutFArc);
+	}
+
+	PeepoHappy::Compression::Method GetFArcEntryCompressionMethod(const FArcFileEntry& entry)
+	{
+		return entry.Flags.GZipCompressed ? PeepoHappy::Compression::Method::GZip : entry.Flags.ZStdCompressed ? PeepoHappy::Compression::Method::ZStd : PeepoHappy::Compression::Method::None;
+	}
+
+	// NOTE: SplitChunks entries start with an unknown u32 followed by a table of compressed chunk sizes, with the chunks themselves stored back to back after it.
+	//		 Returns the start of the first chunk or nullptr if the chunk table doesn't fit inside the entry
+	const u8* ParseFArcEntryChunkTable(const u8* entryData, const FArcFileEntry& entry, std::vector<u32>& outChunkSizes)
+	{
+		const u8* readHead = entryData;
+		const u8* const entryEnd = (entryData + entry.CompressedSize);
+		if (entry.CompressedSize < sizeof(u32))
+			return nullptr;
+
+		const u32 strangeUnkownData = *reinterpret_cast<const u32*>(readHead); readHead += sizeof(u32);
+		u64 remainingCompressedSize = (entry.CompressedSize - sizeof(strangeUnkownData));
+
+		for (size_t safetyLimit = 0; safetyLimit < 0x4000; safetyLimit++)
+		{
+			if (static_cast<size_t>(entryEnd - readHead) < sizeof(u32))
+				return nullptr;
+
+			const u32 chunkSize = *reinterpret_cast<const u32*>(readHead); readHead += sizeof(u32);
+			outChunkSizes.push_back(chunkSize);
+
+			if (remainingCompressedSize <= (static_cast<u64>(chunkSize) + sizeof(chunkSize) + sizeof(u32)))
+				break;
+			remainingCompressedSize -= (chunkSize + sizeof(chunkSize));
+		}
+
+		u64 totalChunkSize = 0;
+		for (const u32 chunkSize : outChunkSizes)
+			totalChunkSize += chunkSize;
+
+		return (totalChunkSize <= static_cast<u64>(entryEnd - readHead)) ? readHead : nullptr;
+	}
+
+	// NOTE: Every chunk is an independently compressed stream so as long as all of their decompressed sizes are known up front
+	//		 they can each be decoded straight into their own slice of the output buffer
+	bool GetFArcEntryChunkOutputOffsets(PeepoHappy::Compression::Method method, const u8* chunkData, const std::vector<u32>& chunkSizes, const FArcFileEntry& entry, std::vector<size_t>& outChunkOutputOffsets)
+	{
+		outChunkOutputOffsets.reserve(chunkSizes.size() + 1);
+		outChunkOutputOffsets.push_back(0);
+
+		size_t chunkInputOffset = 0;
+		for (const u32 chunkSize : chunkSizes)
+		{
+			const size_t decompressedChunkSize = PeepoHappy::Compression::GetDecompressedSize(method, chunkData + chunkInputOffset, chunkSize);
+			if (decompressedChunkSize == PeepoHappy::Compression::UnknownDecompressedSize)
+				return false;
+
+			outChunkOutputOffsets.push_back(outChunkOutputOffsets.back() + decompressedChunkSize);
+			chunkInputOffset += chunkSize;
+		}
+
+		return (outChunkOutputOffsets.back() == entry.UncompressedSize);
+	}
+
+	bool DecompressFArcEntryChunks(PeepoHappy::Compression::Method method, const u8* chunkData, const std::vector<u32>& chunkSizes, const std::vector<size_t>& chunkOutputOffsets, u8* outputData, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		std::atomic<bool> allChunksSuccessful = true;
+		auto decompressChunk = [&, method, outputData](size_t chunkIndex, size_t chunkInputOffset)
+		{
+			const size_t outputOffset = chunkOutputOffsets[chunkIndex];
+			if (!PeepoHappy::Compression::Decompress(method, chunkData + chunkInputOffset, chunkSizes[chunkIndex], outputData + outputOffset, chunkOutputOffsets[chunkIndex + 1] - outputOffset))
+				allChunksSuccessful = false;
+		};
+
+		if (threadPool == nullptr || chunkSizes.size() <= 1)
+		{
+			for (size_t chunkIndex = 0, inputOffset = 0; chunkIndex < chunkSizes.size(); inputOffset += chunkSizes[chunkIndex++])
+				decompressChunk(chunkIndex, inputOffset);
+			return allChunksSuccessful;
+		}
+
+		PeepoHappy::Threading::TaskGroup chunkTaskGroup;
+		for (size_t chunkIndex = 0, inputOffset = 0; chunkIndex < chunkSizes.size(); inputOffset += chunkSizes[chunkIndex++])
+			threadPool->Enqueue(chunkTaskGroup, [&decompressChunk, chunkIndex, inputOffset] { decompressChunk(chunkIndex, inputOffset); });
+
+		threadPool->Wait(chunkTaskGroup);
+		return allChunksSuccessful;
+	}
+
+	const u8* ReadFArcEntryData(const FArc& inFArc, const FArcFileEntry& entry, std::vector<u8>& outDecryptedBuffer)
+	{
+		if ((static_cast<u64>(entry.Offset) + entry.CompressedSize) > inFArc.File.Size())
+			return nullptr;
+
+		return inFArc.EntryDataEncrypted ? DecryptFArcEntryData(inFArc, entry, outDecryptedBuffer) : (inFArc.File.Data() + entry.Offset);
+	}
+
+	bool DecompressFArcEntryDataInto(const u8* entryData, const FArcFileEntry& entry, u8* outputData, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		const auto method = GetFArcEntryCompressionMethod(entry);
+		PeepoHappy::Trace::ScopedEvent decompressEvent("decompress", entry.UncompressedSize, PeepoHappy::Compression::GetMethodName(method), entry.FileName);
+
+		const u8* compressedData = entryData;
+		std::vector<u32> chunkSizes;
+
+		if (entry.Flags.SplitChunks && (compressedData = ParseFArcEntryChunkTable(entryData, entry, chunkSizes)) == nullptr)
+			return false;
+
+		const size_t compressedSizeWithoutChunkTable = (entry.CompressedSize - static_cast<size_t>(compressedData - entryData));
+
+		if (method == PeepoHappy::Compression::Method::None)
+		{
+			if (compressedSizeWithoutChunkTable < entry.UncompressedSize)
+				return false;
+
+			::memcpy(outputData, compressedData, entry.UncompressedSize);
+			return true;
+		}
+
+		if (std::vector<size_t> chunkOutputOffsets; !chunkSizes.empty() && GetFArcEntryChunkOutputOffsets(method, compressedData, chunkSizes, entry, chunkOutputOffsets))
+			return DecompressFArcEntryChunks(method, compressedData, chunkSizes, chunkOutputOffsets, outputData, threadPool);
+
+		return PeepoHappy::Compression::Decompress(method, compressedData, compressedSizeWithoutChunkTable, outputData, entry.UncompressedSize);
+	}
+
+	bool IsFArcEntryDataChecksummed(const u8* entryData, const FArcFileEntry& entry)
+	{
+		const auto method = GetFArcEntryCompressionMethod(entry);
+
+		const u8* compressedData = entryData;
+		std::vector<u32> chunkSizes;
+
+		if (entry.Flags.SplitChunks && (compressedData = ParseFArcEntryChunkTable(entryData, entry, chunkSizes)) == nullptr)
+			return false;
+
+		if (chunkSizes.empty())
+			return PeepoHappy::Compression::HasContentChecksum(method, compressedData, entry.CompressedSize - static_cast<size_t>(compressedData - entryData));
+
+		for (size_t chunkIndex = 0, inputOffset = 0; chunkIndex < chunkSizes.size(); inputOffset += chunkSizes[chunkIndex++])
+		{
+			if (!PeepoHappy::Compression::HasContentChecksum(method, compressedData + inputOffset, chunkSizes[chunkIndex]))
+				return false;
+		}
+		return true;
+	}
+
+	bool DecompressFArcEntryData(const u8* entryData, FArcFileEntry& entry, PeepoHappy::Memory::BufferPool& bufferPool, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		// NOTE: Left uninitialized as it is about to be overwritten in its entirety anyway
+		entry.DecompressedFileContent = bufferPool.Allocate(entry.UncompressedSize);
+		if (DecompressFArcEntryDataInto(entryData, entry, entry.DecompressedFileContent.get(), threadPool))
+			return true;
+
+		fprintf(stderr, "[ERROR] Corrupt entry data for '%.*s'\n", static_cast<int>(entry.FileName.size()), entry.FileName.data());
+		entry.DecompressedFileContent.reset();
+		return false;
+	}
+
+	bool ReadAndDecompressFArcEntry(const FArc& inFArc, FArcFileEntry& entry, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		std::vector<u8> decryptedEntryData;
+		if (const u8* entryData = ReadFArcEntryData(inFArc, entry, decryptedEntryData); entryData != nullptr)
+			return DecompressFArcEntryData(entryData, entry, *inFArc.EntryBufferPool, threadPool);
+
+		fprintf(stderr, "[ERROR] Entry data for '%.*s' extends past the end of the file\n", static_cast<int>(entry.FileName.size()), entry.FileName.data());
+		return false;
+	}
+
+	bool ReadAndDecompressAllFArcEntries(FArc& inOutFArc, PeepoHappy::Threading::ThreadPool& threadPool)
+	{
+		if (!inOutFArc.File.IsOpen() || inOutFArc.File.Size() < 16)
+			return false;
+
+		// NOTE: Schedule the largest entries first so a single huge one doesn't end up running last on an otherwise idle pool
+		std::vector<FArcFileEntry*> sortedEntries;
+		sortedEntries.reserve(inOutFArc.Entries.size());
+		for (auto& entry : inOutFArc.Entries)
+			sortedEntries.push_back(&entry);
+
+		std::stable_sort(sortedEntries.begin(), sortedEntries.end(), [](const FArcFileEntry* a, const FArcFileEntry* b) { return a->CompressedSize > b->CompressedSize; });
+
+		std::atomic<size_t> failedEntryCount = 0;
+		PeepoHappy::Threading::TaskGroup entryTaskGroup;
+		for (auto* entry : sortedEntries)
+		{
+			threadPool.Enqueue(entryTaskGroup, [&inOutFArc, &threadPool, &failedEntryCount, entry]
+			{
+				if (!ReadAndDecompressFArcEntry(inOutFArc, *entry, &threadPool))
+					failedEntryCount++;
+			});
+		}
+
+		threadPool.Wait(entryTaskGroup);
+
+		if (failedEntryCount > 0)
+			fprintf(stderr, "[ERROR] Failed to decompress %zu of %zu entries\n", static_cast<size_t>(failedEntryCount), inOutFArc.Entries.size());
+		return (failedEntryCount == 0);
+	}
+
+	bool ReadAndDecompressAllFArcEntries(FArc& inOutFArc, u32 jobCount)
+	{
+		if (!inOutFArc.File.IsOpen() || inOutFArc.File.Size() < 16)
+			return false;
+
+		if (jobCount <= 1 || inOutFArc.Entries.empty())
+		{
+			size_t failedEntryCount = 0;
+			for (auto& entry : inOutFArc.Entries)
+			{
+				if (!ReadAndDecompressFArcEntry(inOutFArc, entry))
+					failedEntryCount++;
+			}
+
+			if (failedEntryCount > 0)
+				fprintf(stderr, "[ERROR] Failed to decompress %zu of %zu entries\n", failedEntryCount, inOutFArc.Entries.size());
+			return (failedEntryCount == 0);
+		}
+
+		PeepoHappy::Threading::ThreadPool threadPool(jobCount);
+		return ReadAndDecompressAllFArcEntries(inOutFArc, threadPool);
+	}
+
+	bool ExtractWriteFArcEntryIntoDirectory(const FArcFileEntry& entry, std::string_view outputDirectory, PeepoHappy::IO::ContentAddressedStore* contentStore)
+	{
+		if (entry.FileName.empty() || entry.DecompressedFileContent == nullptr)
+			return false;
+
+		std::string outputPath;
+		outputPath.reserve(outputDirectory.size() + 1 + entry.FileName.size());
+		outputPath.append(outputDirectory).append("/").append(entry.FileName);
+
+		if (contentStore != nullptr)
+			return contentStore->WriteFile(outputPath, entry.DecompressedFileContent.get(), entry.UncompressedSize);
+
+		PeepoHappy::Trace::ScopedEvent writeEvent("write", entry.UncompressedSize, "file", entry.FileName);
+		return PeepoHappy::IO::WriteEntireFile(outputPath, entry.DecompressedFileContent.get(), entry.UncompressedSize);
+	}
+
+	// NOTE: Number of files written by the same batch before its results are collected and reported on together
+	constexpr size_t FArcWriteBatchFileCount = 256;
+
+	bool ExtractWriteAllFArcEntriesIntoDirectory(FArc& inFArc, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool, PeepoHappy::IO::ContentAddressedStore* contentStore)
+	{
+		if (!inFArc.File.IsOpen() || inFArc.Signature == FArcSignature::Invalid)
+			return false;
+
+		PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+
+		const size_t entryCount = inFArc.Entries.size();
+		const size_t batchCount = (entryCount + FArcWriteBatchFileCount - 1) / FArcWriteBatchFileCount;
+
+		std::unique_ptr<bool[]> entryWriteResults = std::make_unique<bool[]>(entryCount);
+		auto writeEntry = [&](size_t entryIndex)
+		{
+			auto& entry = inFArc.Entries[entryIndex];
+			entryWriteResults[entryIndex] = ExtractWriteFArcEntryIntoDirectory(entry, outputDirectory, contentStore);
+			entry.DecompressedFileContent.reset();
+		};
+
+		std::vector<PeepoHappy::Threading::TaskGroup> batchTaskGroups(threadPool != nullptr ? batchCount : 0);
+		for (size_t batchIndex = 0; batchIndex < batchTaskGroups.size(); batchIndex++)
+		{
+			const size_t batchEnd = std::min((batchIndex + 1) * FArcWriteBatchFileCount, entryCount);
+			for (size_t entryIndex = batchIndex * FArcWriteBatchFileCount; entryIndex < batchEnd; entryIndex++)
+				threadPool->Enqueue(batchTaskGroups[batchIndex], [&writeEntry, entryIndex] { writeEntry(entryIndex); });
+		}
+
+		size_t totalFailedFileCount = 0;
+		for (size_t batchIndex = 0; batchIndex < batchCount; batchIndex++)
+		{
+			const size_t batchBegin = batchIndex * FArcWriteBatchFileCount;
+			const size_t batchEnd = std::min(batchBegin + FArcWriteBatchFileCount, entryCount);
+
+			if (threadPool != nullptr)
+			{
+				threadPool->Wait(batchTaskGroups[batchIndex]);
+			}
+			else
+			{
+				for (size_t entryIndex = batchBegin; entryIndex < batchEnd; entryIndex++)
+					writeEntry(entryIndex);
+			}
+
+			size_t batchFailedFileCount = 0;
+			for (size_t entryIndex = batchBegin; entryIndex < batchEnd; entryIndex++)
+			{
+				if (entryWriteResults[entryIndex])
+					continue;
+
+				const auto fileName = inFArc.Entries[entryIndex].FileName;
+				fprintf(stderr, "[ERROR] Unable to extract file[%zu] '%.*s'\n", entryIndex, static_cast<int>(fileName.size()), fileName.data());
+				batchFailedFileCount++;
+			}
+
+			if (batchFailedFileCount > 0)
+				fprintf(stderr, "[ERROR] Failed to write %zu of %zu files in batch %zu\n", batchFailedFileCount, (batchEnd - batchBegin), batchIndex);
+			totalFailedFileCount += batchFailedFileCount;
+		}
+
+		return (totalFailedFileCount == 0);
+	}
+
+	bool ExtractFArcEntryDirectIntoDirectory(const FArc& inFArc, const FArcFileEntry& entry, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		if (entry.FileName.empty())
+			return false;
+
+		std::vector<u8> decryptedEntryData;
+		const u8* entryData = ReadFArcEntryData(inFArc, entry, decryptedEntryData);
+		if (entryData == nullptr)
+			return false;
+
+		std::string outputPath;
+		outputPath.reserve(outputDirectory.size() + 1 + entry.FileName.size());
+		outputPath.append(outputDirectory).append("/").append(entry.FileName);
+
+		// NOTE: Includes the time spent decompressing into the mapping as well as the page faults that come with it
+		PeepoHappy::Trace::ScopedEvent writeEvent("write", entry.UncompressedSize, "mapped_file", entry.FileName);
+
+		PeepoHappy::IO::MappedOutputFile outputFile;
+		if (!outputFile.Create(outputPath, entry.UncompressedSize))
+			return false;
+
+		if (entry.UncompressedSize > 0 && !DecompressFArcEntryDataInto(entryData, entry, outputFile.Data(), threadPool))
+			return false;
+
+		return outputFile.Commit();
+	}
+
+	bool ExtractAllFArcEntriesDirectIntoDirectory(const FArc& inFArc, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		if (!inFArc.File.IsOpen() || inFArc.Signature == FArcSignature::Invalid)
+			return false;
+
+		PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+
+		std::atomic<size_t> failedFileCount = 0;
+		auto extractEntry = [&](const FArcFileEntry& entry)
+		{
+			if (!ExtractFArcEntryDirectIntoDirectory(inFArc, entry, outputDirectory, threadPool))
+			{
+				fprintf(stderr, "[ERROR] Unable to extract file[%zu] '%.*s'\n", static_cast<size_t>(std::distance(inFArc.Entries.data(), &entry)), static_cast<int>(entry.FileName.size()), entry.FileName.data());
+				failedFileCount++;
+			}
+		};
+
+		auto reportFailedFiles = [&]
+		{
+			if (failedFileCount > 0)
+				fprintf(stderr, "[ERROR] Failed to extract %zu of %zu files\n", static_cast<size_t>(failedFileCount), inFArc.Entries.size());
+			return (failedFileCount == 0);
+		};
+
+		if (threadPool == nullptr)
+		{
+			for (const auto& entry : inFArc.Entries)
+				extractEntry(entry);
+			return reportFailedFiles();
+		}
+
+		std::vector<const FArcFileEntry*> sortedEntries;
+		sortedEntries.reserve(inFArc.Entries.size());
+		for (const auto& entry : inFArc.Entries)
+			sortedEntries.push_back(&entry);
+
+		std::stable_sort(sortedEntries.begin(), sortedEntries.end(), [](const FArcFileEntry* a, const FArcFileEntry* b) { return a->CompressedSize > b->CompressedSize; });
+
+		PeepoHappy::Threading::TaskGroup entryTaskGroup;
+		for (const auto* entry : sortedEntries)
+			threadPool->Enqueue(entryTaskGroup, [&extractEntry, entry] { extractEntry(*entry); });
+
+		threadPool->Wait(entryTaskGroup);
+		return reportFailedFiles();
+	}
+
+	constexpr std::string_view FArcExtractionManifestFileExtension = ".fman";
+	constexpr u32 FArcExtractionManifestMagic = 'FMAN';
+	constexpr u32 FArcExtractionManifestVersion = 1;
+
+	struct FArcExtractionManifestHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 EntryCount;
+		u32 EntryDataSize;
+		u64 EntryDataHash;
+	};
+
+	struct FArcExtractionManifestFileEntry
+	{
+		u64 CompressedDataHashLow;
+		u64 CompressedDataHashHigh;
+		u32 CompressedSize;
+		u32 UncompressedSize;
+		u32 FileNameLength;
+		u32 Reserved;
+	};
+
+	std::string GetFArcExtractionManifestPath(std::string_view outputDirectory)
+	{
+		return std::string(outputDirectory).append(FArcExtractionManifestFileExtension);
+	}
+
+	bool LoadFArcExtractionManifest(std::string_view outputDirectory, FArcExtractionManifest& outManifest)
+	{
+		outManifest.clear();
+
+		auto[manifestContent, manifestSize] = PeepoHappy::IO::ReadEntireFile(GetFArcExtractionManifestPath(outputDirectory));
+		if (manifestContent == nullptr || manifestSize < sizeof(FArcExtractionManifestHeader))
+			return false;
+
+		FArcExtractionManifestHeader header;
+		::memcpy(&header, manifestContent.get(), sizeof(header));
+
+		const u8* const entryData = (manifestContent.get() + sizeof(header));
+		if (header.Magic != FArcExtractionManifestMagic || header.Version != FArcExtractionManifestVersion || header.EntryDataSize != (manifestSize - sizeof(header)))
+			return false;
+
+		if (header.EntryDataHash != PeepoHappy::Hash::ComputeXXH64(entryData, header.EntryDataSize))
+			return false;
+
+		FArcExtractionManifest manifest;
+		manifest.reserve(header.EntryCount);
+
+		const u8* readHead = entryData;
+		const u8* const entryDataEnd = (entryData + header.EntryDataSize);
+		for (u32 i = 0; i < header.EntryCount; i++)
+		{
+			FArcExtractionManifestFileEntry fileEntry;
+			if (static_cast<size_t>(entryDataEnd - readHead) < sizeof(fileEntry))
+				return false;
+
+			::memcpy(&fileEntry, readHead, sizeof(fileEntry)); readHead += sizeof(fileEntry);
+			if (static_cast<size_t>(entryDataEnd - readHead) < fileEntry.FileNameLength)
+				return false;
+
+			auto& entry = manifest[std::string(reinterpret_cast<const char*>(readHead), fileEntry.FileNameLength)]; readHead += fileEntry.FileNameLength;
+			entry.CompressedSize = fileEntry.CompressedSize;
+			entry.UncompressedSize = fileEntry.UncompressedSize;
+			entry.CompressedDataHash = { fileEntry.CompressedDataHashLow, fileEntry.CompressedDataHashHigh };
+		}
+
+		outManifest = std::move(manifest);
+		return true;
+	}
+
+	bool WriteFArcExtractionManifest(std::string_view outputDirectory, const FArcExtractionManifest& manifest)
+	{
+		std::vector<u8> entryData;
+		for (const auto&[fileName, entry] : manifest)
+		{
+			FArcExtractionManifestFileEntry fileEntry = {};
+			fileEntry.CompressedDataHashLow = entry.CompressedDataHash.Low;
+			fileEntry.CompressedDataHashHigh = entry.CompressedDataHash.High;
+			fileEntry.CompressedSize = entry.CompressedSize;
+			fileEntry.UncompressedSize = entry.UncompressedSize;
+			fileEntry.FileNameLength = static_cast<u32>(fileName.size());
+
+			const auto* fileEntryBytes = reinterpret_cast<const u8*>(&fileEntry);
+			entryData.insert(entryData.end(), fileEntryBytes, fileEntryBytes + sizeof(fileEntry));
+			entryData.insert(entryData.end(), fileName.begin(), fileName.end());
+		}
+
+		FArcExtractionManifestHeader header = {};
+		header.Magic = FArcExtractionManifestMagic;
+		header.Version = FArcExtractionManifestVersion;
+		header.EntryCount = static_cast<u32>(manifest.size());
+		header.EntryDataSize = static_cast<u32>(entryData.size());
+		header.EntryDataHash = PeepoHappy::Hash::ComputeXXH64(entryData.data(), entryData.size());
+
+		std::vector<u8> manifestContent(sizeof(header) + entryData.size());
+		::memcpy(manifestContent.data(), &header, sizeof(header));
+		if (!entryData.empty())
+			::memcpy(manifestContent.data() + sizeof(header), entryData.data(), entryData.size());
+
+		return PeepoHappy::IO::WriteEntireFile(GetFArcExtractionManifestPath(outputDirectory), manifestContent.data(), manifestContent.size());
+	}
+
+	size_t RemoveUnchangedFArcEntries(FArc& inOutFArc, std::string_view outputDirectory, FArcExtractionManifest& inOutManifest, PeepoHappy::Threading::ThreadPool* threadPool)
+	{
+		if (!inOutFArc.File.IsOpen() || inOutFArc.Entries.empty())
+			return 0;
+
+		const size_t entryCount = inOutFArc.Entries.size();
+		std::unique_ptr<PeepoHappy::Hash::Hash128[]> compressedDataHashes = std::make_unique<PeepoHappy::Hash::Hash128[]>(entryCount);
+		std::unique_ptr<bool[]> entryDataReadable = std::make_unique<bool[]>(entryCount);
+
+		auto hashEntry = [&](size_t entryIndex)
+		{
+			const auto& entry = inOutFArc.Entries[entryIndex];
+
+			std::vector<u8> decryptedBuffer;
+			const u8* entryData = ReadFArcEntryData(inOutFArc, entry, decryptedBuffer);
+			entryDataReadable[entryIndex] = (entryData != nullptr);
+			if (entryData != nullptr)
+			{
+				PeepoHappy::Trace::ScopedEvent hashEvent("hash", entry.CompressedSize, "compressed", entry.FileName);
+				compressedDataHashes[entryIndex] = PeepoHappy::Hash::ComputeXXH128(entryData, entry.CompressedSize);
+			}
+		};
+
+		if (threadPool != nullptr)
+		{
+			PeepoHappy::Threading::TaskGroup entryTaskGroup;
+			for (size_t entryIndex = 0; entryIndex < entryCount; entryIndex++)
+				threadPool->Enqueue(entryTaskGroup, [&hashEntry, entryIndex] { hashEntry(entryIndex); });
+			threadPool->Wait(entryTaskGroup);
+		}
+		else
+		{
+			for (size_t entryIndex = 0; entryIndex < entryCount; entryIndex++)
+				hashEntry(entryIndex);
+		}
+
+		std::string outputPath;
+		std::unique_ptr<bool[]> entryUnchanged = std::make_unique<bool[]>(entryCount);
+		for (size_t entryIndex = 0; entryIndex < entryCount; entryIndex++)
+		{
+			const auto& entry = inOutFArc.Entries[entryIndex];
+			const std::string fileName(entry.FileName);
+
+			// NOTE: Unreadable entries are left to fail during extraction, dropping their manifest entry makes sure they are never skipped later on
+			if (!entryDataReadable[entryIndex])
+			{
+				inOutManifest.erase(fileName);
+				continue;
+			}
+
+			const FArcExtractionManifestEntry currentEntry = { entry.CompressedSize, entry.UncompressedSize, compressedDataHashes[entryIndex] };
+			const auto foundEntry = inOutManifest.find(fileName);
+			if (foundEntry != inOutManifest.end() && foundEntry->second == currentEntry)
+			{
+				// NOTE: Output files deleted or modified since are extracted again even if their compressed data hasn't changed
+				outputPath.clear();
+				outputPath.append(outputDirectory).append("/").append(entry.FileName);
+				entryUnchanged[entryIndex] = (PeepoHappy::IO::FileExists(outputPath) && PeepoHappy::IO::GetFileSize(outputPath) == entry.UncompressedSize);
+			}
+
+			inOutManifest.insert_or_assign(fileName, currentEntry);
+		}
+
+		// NOTE: Every element is tested while still at its original position, before anything is moved into it
+		const auto removedEntriesBegin = std::remove_if(inOutFArc.Entries.begin(), inOutFArc.Entries.end(), [&](const FArcFileEntry& entry) { return entryUnchanged[&entry - inOutFArc.Entries.data()]; });
+		const size_t removedEntryCount = static_cast<size_t>(std::distance(removedEntriesBegin, inOutFArc.Entries.end()));
+
+		inOutFArc.Entries.erase(removedEntriesBegin, inOutFArc.Entries.end());
+		RebuildFArcEntryNameIndex(inOutFArc);
+		return removedEntryCount;
+	}
+
+	bool ExtractFArcEntriesPipelined(FArc& inOutFArc, std::string_view outputDirectory, const FArcPipelineSettings& settings)
+	{
+		if (!inOutFArc.File.IsOpen() || inOutFArc.Signature == FArcSignature::Invalid)
+			return false;
+
+		PeepoHappy::IO::CreateFileDirectory(outputDirectory);
+
+		struct PipelineItem
+		{
+			FArcFileEntry* Entry;
+			std::vector<u8> DecryptedData;
+			const u8* EntryData;
+			size_t BudgetByteSize;
+		};
+
+		const u32 decompressJobCount = std::max(settings.DecompressJobCount, 1u);
+		const size_t queueCapacity = (decompressJobCount * 2);
+
+		PeepoHappy::Threading::ByteBudget inFlightBudget(settings.MaxInFlightBytes);
+		PeepoHappy::Threading::BoundedQueue<std::unique_ptr<PipelineItem>> decompressQueue(queueCapacity);
+		PeepoHappy::Threading::BoundedQueue<std::unique_ptr<PipelineItem>> writeQueue(queueCapacity);
+
+		std::vector<std::thread> decompressThreads;
+		decompressThreads.reserve(decompressJobCount);
+		for (u32 i = 0; i < decompressJobCount; i++)
+		{
+			decompressThreads.emplace_back([&]
+			{
+				std::unique_ptr<PipelineItem> item;
+				while (decompressQueue.Pop(item))
+				{
+					if (item->EntryData != nullptr)
+						DecompressFArcEntryData(item->EntryData, *item->Entry, *inOutFArc.EntryBufferPool);
+
+					item->DecryptedData = {};
+					writeQueue.Push(std::move(item));
+				}
+			});
+		}
+
+		size_t failedFileCount = 0;
+		std::thread writeThread([&]
+		{
+			std::unique_ptr<PipelineItem> item;
+			while (writeQueue.Pop(item))
+			{
+				auto& entry = *item->Entry;
+				if (!ExtractWriteFArcEntryIntoDirectory(entry, outputDirectory, settings.ContentStore))
+				{
+					fprintf(stderr, "[ERROR] Unable to extract file[%zu] '%.*s'\n", static_cast<size_t>(std::distance(inOutFArc.Entries.data(), &entry)), static_cast<int>(entry.FileName.size()), entry.FileName.data());
+					failedFileCount++;
+				}
+
+				entry.DecompressedFileContent.reset();
+				inFlightBudget.Release(item->BudgetByteSize);
+			}
+		});
+
+		// NOTE: Read in file order so the mapped file is paged in sequentially
+		std::vector<FArcFileEntry*> entriesInFileOrder;
+		entriesInFileOrder.reserve(inOutFArc.Entries.size());
+		for (auto& entry : inOutFArc.Entries)
+			entriesInFileOrder.push_back(&entry);
+
+		std::stable_sort(entriesInFileOrder.begin(), entriesInFileOrder.end(), [](const FArcFileEntry* a, const FArcFileEntry* b) { return a->Offset < b->Offset; });
+
+		for (auto* entry : entriesInFileOrder)
+		{
+			auto item = std::make_unique<PipelineItem>();
+			item->Entry = entry;
+			item->BudgetByteSize = (entry->UncompressedSize + (inOutFArc.EntryDataEncrypted ? entry->CompressedSize : 0));
+
+			inFlightBudget.Acquire(item->BudgetByteSize);
+
+			{
+				PeepoHappy::Trace::ScopedEvent readEvent("read", entry->CompressedSize, "entry", entry->FileName);
+				item->EntryData = ReadFArcEntryData(inOutFArc, *entry, item->DecryptedData);
+
+				// NOTE: Touch every page of unencrypted data here so the read stage takes the page faults instead of the decompression threads
+				if (!inOutFArc.EntryDataEncrypted && item->EntryData != nullptr)
+				{
+					constexpr size_t pageSize = 4096;
+					volatile u8 pageTouchSink = 0;
+					for (size_t offset = 0; offset < entry->CompressedSize; offset += pageSize)
+						pageTouchSink = item->EntryData[offset];
+				}
+			}
+
+			decompressQueue.Push(std::move(item));
+		}
+
+		decompressQueue.Close();
+		for (auto& thread : decompressThreads)
+			thread.join();
+
+		writeQueue.Close();
+		writeThread.join();
+
+		return (failedFileCount == 0);
+	}
+}
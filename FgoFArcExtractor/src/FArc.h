@@ -0,0 +1,220 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "Compression.h"
+
+#include <unordered_map>
+
+namespace FArcExtractor
+{
+	inline u16 ByteSwapU16(u16 value) { return _byteswap_ushort(value); }
+	inline u32 ByteSwapU32(u32 value) { return _byteswap_ulong(value); }
+	inline u64 ByteSwapU64(u64 value) { return _byteswap_uint64(value); }
+
+	enum class FArcSignature
+	{
+		Invalid = 0,
+		FArC = 1,
+		FARC = 2,
+		FARc = 3,
+	};
+
+	struct FArcFlags
+	{
+		u32 Unk0 : 1;
+		u32 GZipCompressed : 1;
+		u32 Encrypted : 1;
+		u32 Unk3 : 1;
+		u32 Unk4 : 1;
+		u32 Unk5 : 1;
+		u32 ZStdCompressed : 1;
+		u32 Unk7 : 1;
+	};
+
+	struct FArcFileFlags
+	{
+		u32 Unk0 : 1;
+		u32 GZipCompressed : 1;
+		u32 Encrypted : 1;
+		u32 Unk3 : 1;
+		u32 SplitChunks : 1;
+		u32 ZStdCompressed : 1;
+	};
+
+	struct FArcFileEntry
+	{
+		std::string_view FileName;
+		u32 Offset;
+		u32 CompressedSize;
+		u32 UncompressedSize;
+		FArcFileFlags Flags;
+
+		PeepoHappy::Memory::PooledBuffer DecompressedFileContent;
+	};
+
+	enum class FArcDecryptMode
+	{
+		// NOTE: Decrypt the entire payload in place up front, best suited for extracting every entry
+		Eager,
+		// NOTE: Only decrypt the header and entry table, entry data is then decrypted on demand as it is being read
+		Lazy,
+	};
+
+	struct FArc
+	{
+		// NOTE: Mapped copy-on-write so encrypted archives can still be decrypted in place
+		//		 while entries that are never accessed don't have to be paged in at all
+		PeepoHappy::IO::MappedFile File;
+
+		// NOTE: Only used for lazily decrypted archives or archives opened through their entry index cache, in which case all entry FileNames point into this buffer
+		std::unique_ptr<u8[]> DecryptedEntryTable;
+		bool EntryDataEncrypted = false;
+
+		FArcSignature Signature = FArcSignature::Invalid;
+		FArcFlags Flags = {};
+
+		// NOTE: Byte size of the entry table following the header, excluding any padding up to the next AES block
+		size_t EntryTableSize = 0;
+
+		// NOTE: Owns the DecompressedFileContent of all entries and must therefore outlive them.
+		//		 Heap allocated so its address stays stable when the FArc itself is moved
+		std::unique_ptr<PeepoHappy::Memory::BufferPool> EntryBufferPool = std::make_unique<PeepoHappy::Memory::BufferPool>();
+		std::vector<FArcFileEntry> Entries;
+
+		// NOTE: Maps each FileName to its index within Entries, rebuilt whenever the entry table is parsed
+		std::unordered_map<std::string_view, size_t> EntryNameIndex;
+
+		FArc() = default;
+		FArc(FArc&& other) = default;
+
+		FArc& operator=(FArc&& other)
+		{
+			if (this == &other)
+				return *this;
+
+			// NOTE: Release all pooled entry buffers back into the current pool before it is replaced and freed
+			EntryNameIndex.clear();
+			Entries.clear();
+
+			File = std::move(other.File);
+			DecryptedEntryTable = std::move(other.DecryptedEntryTable);
+			EntryDataEncrypted = other.EntryDataEncrypted;
+			Signature = other.Signature;
+			Flags = other.Flags;
+			EntryTableSize = other.EntryTableSize;
+			EntryBufferPool = std::move(other.EntryBufferPool);
+			Entries = std::move(other.Entries);
+			EntryNameIndex = std::move(other.EntryNameIndex);
+			return *this;
+		}
+
+		FArcFileEntry* FindEntry(std::string_view fileName)
+		{
+			const auto foundIndex = EntryNameIndex.find(fileName);
+			return (foundIndex != EntryNameIndex.end()) ? &Entries[foundIndex->second] : nullptr;
+		}
+
+		const FArcFileEntry* FindEntry(std::string_view fileName) const
+		{
+			const auto foundIndex = EntryNameIndex.find(fileName);
+			return (foundIndex != EntryNameIndex.end()) ? &Entries[foundIndex->second] : nullptr;
+		}
+	};
+
+	static_assert(sizeof(FArcFileFlags) == sizeof(u32));
+	static_assert(sizeof(FArcFlags) == sizeof(u32));
+
+	constexpr std::string_view FArcAes128KeyHexString = "62EC7CD79141695E53592ACC10CDC04C";
+	constexpr size_t FArcUnencryptedHeaderSize = 16;
+	constexpr size_t FArcEncryptedDataOffset = FArcUnencryptedHeaderSize + PeepoHappy::Crypto::Aes128IVSize;
+
+	struct FArcPipelineSettings
+	{
+		u32 DecompressJobCount = 1;
+		size_t MaxInFlightBytes = (512 * 1024 * 1024);
+		// NOTE: Optional, see ExtractWriteFArcEntryIntoDirectory()
+		PeepoHappy::IO::ContentAddressedStore* ContentStore = nullptr;
+	};
+
+	void RebuildFArcEntryNameIndex(FArc& inOutFArc);
+
+	// NOTE: Returns false and clears all entries if the entry table extends past the end of the provided data
+	bool ParseFArcEntryTable(const u8* tableData, size_t tableSize, FArc& outFArc);
+
+	// NOTE: With useEntryIndexCache the entry index cache is loaded instead of decrypting and parsing the entry table if it is still valid
+	//		 and otherwise (re)written once the entry table has been parsed. It is only used if the entry data is left undecrypted or isn't encrypted to begin with
+	//		 Eagerly decrypted archives are decrypted in slices on the thread pool, if any
+	FArc OpenReadDecryptAndParseFArcEntries(std::string_view inputFArcPath, PeepoHappy::Threading::ThreadPool* threadPool = nullptr, FArcDecryptMode decryptMode = FArcDecryptMode::Eager, bool useEntryIndexCache = false);
+
+	// NOTE: Random access CBC decryption of the block aligned range covering the entry using the ciphertext block right before it as IV.
+	//		 Returns a pointer to the start of the entry data within the output buffer
+	const u8* DecryptFArcEntryData(const FArc& inFArc, const FArcFileEntry& entry, std::vector<u8>& outDecryptedBuffer);
+
+	// NOTE: Removes all entries not matching any of the include patterns (if there are any) or matching any of the exclude patterns
+	void FilterFArcEntries(FArc& inOutFArc, const std::vector<std::string_view>& includePatterns, const std::vector<std::string_view>& excludePatterns);
+
+	PeepoHappy::Compression::Method GetFArcEntryCompressionMethod(const FArcFileEntry& entry);
+
+	// NOTE: Returns the start of the compressed entry data, pointing either into the mapped file or into the decrypted output buffer,
+	//		 or nullptr if the entry extends past the end of the file
+	const u8* ReadFArcEntryData(const FArc& inFArc, const FArcFileEntry& entry, std::vector<u8>& outDecryptedBuffer);
+
+	// NOTE: Decompresses the entry into an output buffer of at least UncompressedSize bytes, such as a heap buffer or a mapped output file.
+	//		 Returns false if the compressed data is corrupt, including mismatching GZip CRC32 / ISIZE trailers and zstd frame checksums
+	bool DecompressFArcEntryDataInto(const u8* entryData, const FArcFileEntry& entry, u8* outputData, PeepoHappy::Threading::ThreadPool* threadPool = nullptr);
+
+	// NOTE: Whether every compressed stream of the entry carries a checksum of its decompressed data that is verified as part of decompressing it
+	bool IsFArcEntryDataChecksummed(const u8* entryData, const FArcFileEntry& entry);
+
+	bool DecompressFArcEntryData(const u8* entryData, FArcFileEntry& entry, PeepoHappy::Memory::BufferPool& bufferPool, PeepoHappy::Threading::ThreadPool* threadPool = nullptr);
+
+	bool ReadAndDecompressFArcEntry(const FArc& inFArc, FArcFileEntry& entry, PeepoHappy::Threading::ThreadPool* threadPool = nullptr);
+
+	// NOTE: Returns false if any single entry couldn't be read or decompressed, leaving its DecompressedFileContent empty
+	bool ReadAndDecompressAllFArcEntries(FArc& inOutFArc, PeepoHappy::Threading::ThreadPool& threadPool);
+
+	bool ReadAndDecompressAllFArcEntries(FArc& inOutFArc, u32 jobCount = 1);
+
+	// NOTE: With a content store the decompressed content is hashed first and the output file hardlinked to the store's blob of identical content,
+	//		 so that duplicate entries within and across archives are only written to disk once. The output directory has to exist already
+	bool ExtractWriteFArcEntryIntoDirectory(const FArcFileEntry& entry, std::string_view outputDirectory, PeepoHappy::IO::ContentAddressedStore* contentStore = nullptr);
+
+	// NOTE: Splits the entries into batches of files written concurrently on the thread pool, if any.
+	//		 Every batch is waited on in submission order so failed writes are reported per batch instead of being silently dropped.
+	//		 Releases every decompressed buffer as soon as it has been written
+	bool ExtractWriteAllFArcEntriesIntoDirectory(FArc& inFArc, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool = nullptr, PeepoHappy::IO::ContentAddressedStore* contentStore = nullptr);
+
+	// NOTE: Decompresses straight into a memory mapped output file preallocated to its final size,
+	//		 skipping both the intermediate heap buffer and the copy through WriteFile()
+	bool ExtractFArcEntryDirectIntoDirectory(const FArc& inFArc, const FArcFileEntry& entry, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool = nullptr);
+
+	bool ExtractAllFArcEntriesDirectIntoDirectory(const FArc& inFArc, std::string_view outputDirectory, PeepoHappy::Threading::ThreadPool* threadPool);
+
+	struct FArcExtractionManifestEntry
+	{
+		u32 CompressedSize;
+		u32 UncompressedSize;
+		PeepoHappy::Hash::Hash128 CompressedDataHash;
+
+		bool operator==(const FArcExtractionManifestEntry& other) const { return (CompressedSize == other.CompressedSize && UncompressedSize == other.UncompressedSize && CompressedDataHash == other.CompressedDataHash); }
+		bool operator!=(const FArcExtractionManifestEntry& other) const { return !(*this == other); }
+	};
+
+	// NOTE: Maps the FileName of every entry extracted into an output directory to the (decrypted) compressed data it was extracted from.
+	//		 Stored as a "{output_directory}.fman" sidecar file next to the output directory so it never ends up among the extracted files themselves
+	using FArcExtractionManifest = std::unordered_map<std::string, FArcExtractionManifestEntry>;
+
+	// NOTE: Returns false and leaves the manifest empty if there is none yet or if it is corrupted
+	bool LoadFArcExtractionManifest(std::string_view outputDirectory, FArcExtractionManifest& outManifest);
+	bool WriteFArcExtractionManifest(std::string_view outputDirectory, const FArcExtractionManifest& manifest);
+
+	// NOTE: Hashes the compressed data of every entry, which is far cheaper than decompressing it, and removes all entries matching their manifest entry
+	//		 whose output file still exists at its expected size so that neither their decompression nor their write has to happen again.
+	//		 The manifest is updated to the current hashes of all remaining entries and should only be written back once they have been extracted successfully.
+	//		 Returns the number of removed entries
+	size_t RemoveUnchangedFArcEntries(FArc& inOutFArc, std::string_view outputDirectory, FArcExtractionManifest& inOutManifest, PeepoHappy::Threading::ThreadPool* threadPool = nullptr);
+
+	// NOTE: Overlaps reading and decrypting, decompressing and writing of entries by running each stage on its own threads connected through bounded queues.
+	//		 Every entry holds on to its share of the in-flight byte budget from the moment it is read until its decompressed buffer has been written and released
+	bool ExtractFArcEntriesPipelined(FArc& inOutFArc, std::string_view outputDirectory, const FArcPipelineSettings& settings);
+}
@@ -0,0 +1,313 @@
+#include "FArcBuilder.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace FArcExtractor
+{
+	namespace
+	{
+		void AppendU32BE(std::vector<u8>& outData, u32 value)
+		{
+			const u32 swappedValue = ByteSwapU32(value);
+			const u8* valueBytes = reinterpret_cast<const u8*>(&swappedValue);
+			outData.insert(outData.end(), valueBytes, valueBytes + sizeof(u32));
+		}
+	}
+
+	int GetDefaultCompressionLevel(PeepoHappy::Compression::Method method)
+	{
+		return (method == PeepoHappy::Compression::Method::ZStd) ? PeepoHappy::Compression::DefaultZStdLevel : PeepoHappy::Compression::DefaultGZipLevel;
+	}
+
+	bool CompressFArcEntryContent(const u8* content, size_t contentSize, PeepoHappy::Compression::Method method, size_t splitChunkSize, int level, std::vector<u8>& outCompressedData)
+	{
+		if (splitChunkSize == 0 || method == PeepoHappy::Compression::Method::None)
+			return PeepoHappy::Compression::Compress(method, content, contentSize, outCompressedData, level);
+
+		// NOTE: Unknown u32 (written as the chunk count) followed by the little endian compressed size of every chunk and then the chunks themselves
+		const size_t chunkCount = std::max<size_t>((contentSize + splitChunkSize - 1) / splitChunkSize, 1);
+		outCompressedData.assign(sizeof(u32) * (chunkCount + 1), 0);
+		*reinterpret_cast<u32*>(outCompressedData.data()) = static_cast<u32>(chunkCount);
+
+		std::vector<u8> compressedChunk;
+		for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+		{
+			const size_t chunkOffset = (chunkIndex * splitChunkSize);
+			const size_t chunkSize = std::min(splitChunkSize, contentSize - chunkOffset);
+			if (!PeepoHappy::Compression::Compress(method, content + chunkOffset, chunkSize, compressedChunk, level))
+				return false;
+
+			reinterpret_cast<u32*>(outCompressedData.data())[chunkIndex + 1] = static_cast<u32>(compressedChunk.size());
+			outCompressedData.insert(outCompressedData.end(), compressedChunk.begin(), compressedChunk.end());
+		}
+
+		return true;
+	}
+
+	FArcBuildEntrySource MakeFileEntrySource(std::string_view sourceFilePath)
+	{
+		return [sourceFilePath = std::string(sourceFilePath)](std::vector<u8>& outContent)
+		{
+			auto[fileContent, fileSize] = PeepoHappy::IO::ReadEntireFile(sourceFilePath);
+			outContent.assign(fileContent.get(), fileContent.get() + fileSize);
+			return (fileContent != nullptr || (fileSize == 0 && PeepoHappy::IO::FileExists(sourceFilePath)));
+		};
+	}
+
+	FArcBuilder::FArcBuilder(const FArcBuildSettings& settings) : settings(settings)
+	{
+	}
+
+	void FArcBuilder::AddSource(std::string_view fileName, size_t sizeHint, FArcBuildEntrySource source)
+	{
+		entries.push_back({ std::string(fileName), sizeHint, std::move(source) });
+	}
+
+	void FArcBuilder::AddFile(std::string_view fileName, std::string_view sourceFilePath)
+	{
+		AddSource(fileName, static_cast<size_t>(PeepoHappy::IO::GetFileSize(sourceFilePath)), MakeFileEntrySource(sourceFilePath));
+	}
+
+	void FArcBuilder::AddDirectory(std::string_view directoryPath)
+	{
+		auto filePaths = PeepoHappy::IO::GetFilesInDirectory(directoryPath);
+		std::sort(filePaths.begin(), filePaths.end());
+
+		for (const auto& filePath : filePaths)
+			AddFile(PeepoHappy::Path::GetFileName(filePath), filePath);
+	}
+
+	size_t FArcBuilder::GetEntryCount() const
+	{
+		return entries.size();
+	}
+
+	bool FArcBuilder::Build(std::string_view outputFArcPath)
+	{
+		const auto method = settings.CompressionMethod;
+		const size_t alignment = std::max<size_t>(settings.Alignment, 1);
+		const size_t payloadFileOffset = settings.Encrypted ? FArcEncryptedDataOffset : FArcUnencryptedHeaderSize;
+		// NOTE: Encrypted entry offsets are stored excluding the AES key size, which the parser adds back on
+		const size_t storedOffsetBias = settings.Encrypted ? PeepoHappy::Crypto::Aes128KeySize : 0;
+
+		size_t entryTableSize = (sizeof(u32) * 4);
+		for (const auto& entry : entries)
+			entryTableSize += entry.FileName.size() + sizeof('\0') + (sizeof(u32) * 4);
+
+		PeepoHappy::IO::StreamOutputFile outputFile;
+		if (!outputFile.Create(outputFArcPath))
+		{
+			fprintf(stderr, "[ERROR] Unable to create output FArc file '%.*s'\n", static_cast<int>(outputFArcPath.size()), outputFArcPath.data());
+			return false;
+		}
+
+		// NOTE: The header and entry table are only written once every entry offset and size is known, so reserve their space up front
+		const std::vector<u8> reservedSpace(payloadFileOffset + entryTableSize, 0);
+		if (!outputFile.Write(reservedSpace.data(), reservedSpace.size()))
+			return false;
+
+		struct CompressedEntry
+		{
+			std::vector<u8> Data;
+			u32 UncompressedSize = 0;
+			size_t BudgetByteSize = 0;
+			bool IsReady = false;
+			bool WasSuccessful = false;
+		};
+
+		struct EntryTableRow
+		{
+			u32 Offset;
+			u32 CompressedSize;
+			u32 UncompressedSize;
+		};
+
+		std::vector<CompressedEntry> compressedEntries(entries.size());
+		std::vector<EntryTableRow> entryTableRows(entries.size());
+
+		std::mutex readyMutex;
+		std::condition_variable readyCondition;
+
+		PeepoHappy::Threading::ThreadPool threadPool(settings.JobCount);
+		PeepoHappy::Threading::ByteBudget inFlightBudget(settings.MaxInFlightBytes);
+
+		size_t failedEntryCount = 0;
+		std::thread writeThread([&]
+		{
+			for (size_t entryIndex = 0; entryIndex < compressedEntries.size(); entryIndex++)
+			{
+				auto& compressedEntry = compressedEntries[entryIndex];
+				{
+					std::unique_lock lock(readyMutex);
+					readyCondition.wait(lock, [&] { return compressedEntry.IsReady; });
+				}
+
+				// NOTE: Keep going after a failure so every entry still releases its share of the budget
+				const u64 entryFileOffset = PeepoHappy::Crypto::Align(static_cast<size_t>(outputFile.Size()), alignment);
+				if (compressedEntry.WasSuccessful && (entryFileOffset + compressedEntry.Data.size()) > std::numeric_limits<u32>::max())
+				{
+					fprintf(stderr, "[ERROR] Entry '%s' extends past the 4 GB limit of 32-bit entry offsets\n", entries[entryIndex].FileName.c_str());
+					compressedEntry.WasSuccessful = false;
+				}
+
+				if (compressedEntry.WasSuccessful)
+				{
+					PeepoHappy::Trace::ScopedEvent writeEvent("write", compressedEntry.Data.size(), "farc_entry", entries[entryIndex].FileName);
+
+					const std::vector<u8> alignmentPadding(static_cast<size_t>(entryFileOffset - outputFile.Size()), 0);
+					compressedEntry.WasSuccessful = outputFile.Write(alignmentPadding.data(), alignmentPadding.size()) && outputFile.Write(compressedEntry.Data.data(), compressedEntry.Data.size());
+					entryTableRows[entryIndex] = { static_cast<u32>(entryFileOffset - storedOffsetBias), static_cast<u32>(compressedEntry.Data.size()), compressedEntry.UncompressedSize };
+				}
+
+				if (!compressedEntry.WasSuccessful)
+				{
+					fprintf(stderr, "[ERROR] Unable to pack file[%zu] '%s'\n", entryIndex, entries[entryIndex].FileName.c_str());
+					failedEntryCount++;
+				}
+
+				compressedEntry.Data = {};
+				inFlightBudget.Release(compressedEntry.BudgetByteSize);
+			}
+		});
+
+		PeepoHappy::Threading::TaskGroup compressTaskGroup;
+		for (size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+		{
+			// NOTE: Accounts for both the uncompressed content and the (at worst slightly larger) compressed output
+			auto& compressedEntry = compressedEntries[entryIndex];
+			compressedEntry.BudgetByteSize = (entries[entryIndex].SizeHint * 2);
+			inFlightBudget.Acquire(compressedEntry.BudgetByteSize);
+
+			threadPool.Enqueue(compressTaskGroup, [&, entryIndex]
+			{
+				auto& compressedEntry = compressedEntries[entryIndex];
+				const bool wasSuccessful = CompressEntry(entries[entryIndex], compressedEntry.Data, compressedEntry.UncompressedSize);
+				{
+					std::scoped_lock lock(readyMutex);
+					compressedEntry.WasSuccessful = wasSuccessful;
+					compressedEntry.IsReady = true;
+				}
+				readyCondition.notify_all();
+			});
+		}
+
+		threadPool.Wait(compressTaskGroup);
+		writeThread.join();
+
+		if (failedEntryCount > 0)
+			return false;
+
+		FArcFileFlags entryFlags = {};
+		entryFlags.GZipCompressed = (method == PeepoHappy::Compression::Method::GZip);
+		entryFlags.ZStdCompressed = (method == PeepoHappy::Compression::Method::ZStd);
+		entryFlags.Encrypted = settings.Encrypted;
+		entryFlags.SplitChunks = (settings.SplitChunkSize > 0 && method != PeepoHappy::Compression::Method::None);
+
+		std::vector<u8> entryTable;
+		entryTable.reserve(entryTableSize);
+		AppendU32BE(entryTable, static_cast<u32>(alignment));
+		AppendU32BE(entryTable, 1);
+		AppendU32BE(entryTable, static_cast<u32>(entries.size()));
+		AppendU32BE(entryTable, static_cast<u32>(alignment));
+
+		for (size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+		{
+			const auto& row = entryTableRows[entryIndex];
+			entryTable.insert(entryTable.end(), entries[entryIndex].FileName.begin(), entries[entryIndex].FileName.end());
+			entryTable.push_back('\0');
+			AppendU32BE(entryTable, row.Offset);
+			AppendU32BE(entryTable, row.CompressedSize);
+			AppendU32BE(entryTable, row.UncompressedSize);
+			AppendU32BE(entryTable, *reinterpret_cast<const u32*>(&entryFlags));
+		}
+
+		FArcFlags farcFlags = {};
+		farcFlags.GZipCompressed = entryFlags.GZipCompressed;
+		farcFlags.ZStdCompressed = entryFlags.ZStdCompressed;
+		farcFlags.Encrypted = settings.Encrypted;
+
+		const u32 signature = (settings.Signature == FArcSignature::FArC) ? 'FArC' : (settings.Signature == FArcSignature::FARc) ? 'FARc' : 'FARC';
+
+		std::vector<u8> header;
+		AppendU32BE(header, signature);
+		AppendU32BE(header, static_cast<u32>(payloadFileOffset - (sizeof(u32) * 2) + entryTableSize));
+		AppendU32BE(header, *reinterpret_cast<const u32*>(&farcFlags));
+		AppendU32BE(header, 0);
+
+		if (!outputFile.WriteAt(0, header.data(), header.size()) || !outputFile.WriteAt(payloadFileOffset, entryTable.data(), entryTable.size()))
+			return false;
+
+		if (settings.Encrypted)
+		{
+			PeepoHappy::Crypto::Aes128IVBytes iv = {};
+			if (settings.IV.has_value())
+			{
+				iv = *settings.IV;
+			}
+			else
+			{
+				std::random_device randomDevice;
+				for (auto& ivByte : iv)
+					ivByte = static_cast<u8>(randomDevice());
+			}
+
+			const size_t paddingSize = (PeepoHappy::Crypto::Align(static_cast<size_t>(outputFile.Size()), PeepoHappy::Crypto::Aes128Alignment) - static_cast<size_t>(outputFile.Size()));
+			const std::vector<u8> blockPadding(paddingSize, 0);
+
+			if (!outputFile.Write(blockPadding.data(), blockPadding.size()) || !outputFile.WriteAt(FArcUnencryptedHeaderSize, iv.data(), iv.size()) || !EncryptPayloadInPlace(outputFile, iv))
+				return false;
+		}
+
+		return outputFile.Commit();
+	}
+
+	bool FArcBuilder::CompressEntry(const PendingEntry& entry, std::vector<u8>& outCompressedData, u32& outUncompressedSize) const
+	{
+		std::vector<u8> content;
+		{
+			PeepoHappy::Trace::ScopedEvent readEvent("read", entry.SizeHint, "source", entry.FileName);
+			if (!entry.Source(content) || content.size() > std::numeric_limits<u32>::max())
+				return false;
+		}
+
+		const auto method = settings.CompressionMethod;
+		const int level = settings.CompressionLevel.value_or(GetDefaultCompressionLevel(method));
+
+		PeepoHappy::Trace::ScopedEvent compressEvent("compress", content.size(), PeepoHappy::Compression::GetMethodName(method), entry.FileName);
+		outUncompressedSize = static_cast<u32>(content.size());
+
+		return CompressFArcEntryContent(content.data(), content.size(), method, settings.SplitChunkSize, level, outCompressedData);
+	}
+
+	bool FArcBuilder::EncryptPayloadInPlace(PeepoHappy::IO::StreamOutputFile& outputFile, const PeepoHappy::Crypto::Aes128IVBytes& iv) const
+	{
+		constexpr size_t encryptChunkSize = (4 * 1024 * 1024);
+		static_assert((encryptChunkSize % PeepoHappy::Crypto::Aes128Alignment) == 0);
+
+		const auto key = PeepoHappy::Crypto::ParseAes128KeyHexByteString(FArcAes128KeyHexString);
+		PeepoHappy::Crypto::Aes128IVBytes chainIV = iv;
+
+		std::vector<u8> chunk;
+		for (u64 chunkOffset = FArcEncryptedDataOffset; chunkOffset < outputFile.Size(); chunkOffset += encryptChunkSize)
+		{
+			chunk.resize(static_cast<size_t>(std::min<u64>(encryptChunkSize, outputFile.Size() - chunkOffset)));
+			PeepoHappy::Trace::ScopedEvent encryptEvent("encrypt", chunk.size(), "payload");
+
+			if (!outputFile.ReadAt(chunkOffset, chunk.data(), chunk.size()))
+				return false;
+
+			if (!PeepoHappy::Crypto::EncryptAes128Cbc(chunk.data(), chunk.data(), chunk.size(), key, chainIV))
+				return false;
+
+			// NOTE: Continue the CBC chain from the last ciphertext block of this chunk
+			::memcpy(chainIV.data(), chunk.data() + chunk.size() - chainIV.size(), chainIV.size());
+
+			if (!outputFile.WriteAt(chunkOffset, chunk.data(), chunk.size()))
+				return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "FArc.h"
+
+#include <optional>
+
+namespace FArcExtractor
+{
+	struct FArcBuildSettings
+	{
+		FArcSignature Signature = FArcSignature::FARC;
+		PeepoHappy::Compression::Method CompressionMethod = PeepoHappy::Compression::Method::GZip;
+		// NOTE: Defaults to the DefaultGZipLevel or DefaultZStdLevel depending on the compression method
+		std::optional<int> CompressionLevel;
+		// NOTE: Splits entries into independently compressed chunks of this size, zero to compress every entry as a single stream
+		size_t SplitChunkSize = 0;
+
+		bool Encrypted = false;
+		// NOTE: Randomly generated unless specified, only needs to be fixed for reproducible builds
+		std::optional<PeepoHappy::Crypto::Aes128IVBytes> IV;
+
+		// NOTE: Stored as both maybeAlignmentA and maybeAlignmentB of the entry table with every entry starting at a file offset aligned to it
+		u32 Alignment = 16;
+
+		u32 JobCount = 1;
+		// NOTE: Upper bound for the uncompressed and compressed data of all entries that are being compressed or waiting to be written
+		size_t MaxInFlightBytes = (256 * 1024 * 1024);
+	};
+
+	int GetDefaultCompressionLevel(PeepoHappy::Compression::Method method);
+
+	// NOTE: Compresses the content of a single entry the way it is stored inside the archive, as split chunks if splitChunkSize is non zero
+	bool CompressFArcEntryContent(const u8* content, size_t contentSize, PeepoHappy::Compression::Method method, size_t splitChunkSize, int level, std::vector<u8>& outCompressedData);
+
+	// NOTE: Produces the content of a single entry on demand from one of the compression threads
+	using FArcBuildEntrySource = std::function<bool(std::vector<u8>& outContent)>;
+
+	FArcBuildEntrySource MakeFileEntrySource(std::string_view sourceFilePath);
+
+	// NOTE: Builds the same archive layout parsed by OpenReadDecryptAndParseFArcEntries().
+	//		 Entries are read and compressed concurrently and written out in order as soon as they are ready,
+	//		 so only a bounded number of them ever have to be held in memory at the same time.
+	//		 Encrypted archives are written out in plain text first and then encrypted in place in a single sequential pass
+	//		 because the entry table leading the CBC chain can only be known once every entry has been compressed
+	class FArcBuilder : NonCopyable
+	{
+	public:
+		explicit FArcBuilder(const FArcBuildSettings& settings);
+
+	public:
+		void AddSource(std::string_view fileName, size_t sizeHint, FArcBuildEntrySource source);
+		void AddFile(std::string_view fileName, std::string_view sourceFilePath);
+		// NOTE: Adds every file directly inside the directory (non recursive) sorted by name
+		void AddDirectory(std::string_view directoryPath);
+
+		size_t GetEntryCount() const;
+
+		bool Build(std::string_view outputFArcPath);
+
+	private:
+		struct PendingEntry
+		{
+			std::string FileName;
+			size_t SizeHint;
+			FArcBuildEntrySource Source;
+		};
+
+		bool CompressEntry(const PendingEntry& entry, std::vector<u8>& outCompressedData, u32& outUncompressedSize) const;
+		bool EncryptPayloadInPlace(PeepoHappy::IO::StreamOutputFile& outputFile, const PeepoHappy::Crypto::Aes128IVBytes& iv) const;
+
+	private:
+		FArcBuildSettings settings;
+		std::vector<PendingEntry> entries;
+	};
+}
@@ -0,0 +1,294 @@
+#include "FArcUpdater.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace FArcExtractor
+{
+	namespace
+	{
+		constexpr size_t BlockSize = PeepoHappy::Crypto::Aes128Alignment;
+
+		struct UpdatedEntry
+		{
+			std::string FileName;
+			u64 Offset;
+			u32 CompressedSize;
+			u32 UncompressedSize;
+			FArcFileFlags Flags;
+			PeepoHappy::Compression::Method CompressionMethod;
+
+			// NOTE: Byte offset of the offset, size and flags fields relative to the start of the entry table
+			size_t TableFieldsOffset;
+			bool WasReplaced;
+		};
+
+		struct ByteRange
+		{
+			u64 Start;
+			u64 End;
+		};
+
+		u64 AlignUp(u64 value, u64 alignment)
+		{
+			return ((value + (alignment - 1)) / alignment) * alignment;
+		}
+
+		u64 FindFreeEntryDataOffset(const std::vector<UpdatedEntry>& entries, size_t replacedEntryIndex, u64 reservedSize, size_t dataSize, u32 alignment, bool isEncrypted)
+		{
+			std::vector<ByteRange> usedRanges;
+			usedRanges.reserve(entries.size() + 1);
+			usedRanges.push_back({ 0, reservedSize });
+
+			for (size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+			{
+				if (entryIndex != replacedEntryIndex && entries[entryIndex].CompressedSize > 0)
+					usedRanges.push_back({ entries[entryIndex].Offset, entries[entryIndex].Offset + entries[entryIndex].CompressedSize });
+			}
+
+			std::sort(usedRanges.begin(), usedRanges.end(), [](const ByteRange& a, const ByteRange& b) { return (a.Start < b.Start); });
+
+			auto fitsIntoGap = [&](u64 gapStart, u64 gapEnd)
+			{
+				const u64 dataEnd = AlignUp(gapStart, alignment) + dataSize;
+
+				// NOTE: The block following the encrypted again ones keeps its old ciphertext and no longer decrypts to anything meaningful
+				return isEncrypted ? ((PeepoHappy::Crypto::Align(dataEnd, BlockSize) + BlockSize) <= gapEnd) : (dataEnd <= gapEnd);
+			};
+
+			u64 gapStart = 0;
+			for (const auto& usedRange : usedRanges)
+			{
+				if (usedRange.Start > gapStart && fitsIntoGap(gapStart, usedRange.Start))
+					return AlignUp(gapStart, alignment);
+				gapStart = std::max(gapStart, usedRange.End);
+			}
+
+			// NOTE: Everything past the last used byte is free, growing the file if necessary
+			return AlignUp(gapStart, alignment);
+		}
+
+		bool WriteEntryData(PeepoHappy::IO::StreamOutputFile& farcFile, u64 dataOffset, const std::vector<u8>& data)
+		{
+			if (dataOffset > farcFile.Size())
+			{
+				const std::vector<u8> paddingData(static_cast<size_t>(dataOffset - farcFile.Size()), 0);
+				if (!farcFile.Write(paddingData.data(), paddingData.size()))
+					return false;
+			}
+
+			return farcFile.WriteAt(dataOffset, data.data(), data.size());
+		}
+
+		bool WriteEncryptedEntryData(PeepoHappy::IO::StreamOutputFile& farcFile, u64 dataOffset, const std::vector<u8>& data, const PeepoHappy::Crypto::Aes128KeyBytes& key)
+		{
+			const u64 encryptedDataEnd = FArcEncryptedDataOffset + ((farcFile.Size() - FArcEncryptedDataOffset) & ~static_cast<u64>(BlockSize - 1));
+			// NOTE: Data appended past the end of the file is preceded by padding which is encrypted along with it to continue the CBC chain
+			const u64 rewriteStart = std::min(dataOffset & ~static_cast<u64>(BlockSize - 1), encryptedDataEnd);
+			const u64 rewriteEnd = PeepoHappy::Crypto::Align(dataOffset + data.size(), BlockSize);
+
+			PeepoHappy::Crypto::Aes128IVBytes iv = {};
+			if (!farcFile.ReadAt(rewriteStart - BlockSize, iv.data(), iv.size()))
+				return false;
+
+			std::vector<u8> blocks(static_cast<size_t>(rewriteEnd - rewriteStart), 0);
+
+			// NOTE: The first block may still be shared with the end of the entry table or another entry whose data has to be encrypted again unchanged,
+			//		 everything else within the rewritten blocks is either part of the new data or free space
+			if (dataOffset > rewriteStart && rewriteStart < encryptedDataEnd)
+			{
+				if (!farcFile.ReadAt(rewriteStart, blocks.data(), BlockSize))
+					return false;
+				PeepoHappy::Crypto::DecryptAes128Cbc(blocks.data(), blocks.data(), BlockSize, key, iv);
+			}
+
+			::memcpy(blocks.data() + (dataOffset - rewriteStart), data.data(), data.size());
+
+			PeepoHappy::Trace::ScopedEvent encryptEvent("encrypt", blocks.size(), "entry");
+			if (!PeepoHappy::Crypto::EncryptAes128Cbc(blocks.data(), blocks.data(), blocks.size(), key, iv))
+				return false;
+
+			return WriteEntryData(farcFile, rewriteStart, blocks);
+		}
+
+		std::array<u8, sizeof(u32) * 4> GetEntryTableFields(const UpdatedEntry& entry, bool isEncrypted)
+		{
+			const u32 storedOffset = static_cast<u32>(entry.Offset - (isEncrypted ? PeepoHappy::Crypto::Aes128KeySize : 0));
+			const u32 fields[] = { storedOffset, entry.CompressedSize, entry.UncompressedSize, *reinterpret_cast<const u32*>(&entry.Flags) };
+
+			std::array<u8, sizeof(u32) * 4> fieldBytes;
+			for (size_t fieldIndex = 0; fieldIndex < std::size(fields); fieldIndex++)
+			{
+				const u32 swappedField = ByteSwapU32(fields[fieldIndex]);
+				::memcpy(fieldBytes.data() + (fieldIndex * sizeof(u32)), &swappedField, sizeof(u32));
+			}
+			return fieldBytes;
+		}
+
+		bool WriteEntryTableFields(PeepoHappy::IO::StreamOutputFile& farcFile, const std::vector<UpdatedEntry>& entries, bool isEncrypted, const PeepoHappy::Crypto::Aes128KeyBytes& key)
+		{
+			if (!isEncrypted)
+			{
+				for (const auto& entry : entries)
+				{
+					const auto fieldBytes = GetEntryTableFields(entry, isEncrypted);
+					if (entry.WasReplaced && !farcFile.WriteAt(FArcUnencryptedHeaderSize + entry.TableFieldsOffset, fieldBytes.data(), fieldBytes.size()))
+						return false;
+				}
+				return true;
+			}
+
+			size_t rewriteEnd = FArcEncryptedDataOffset;
+			for (const auto& entry : entries)
+			{
+				if (entry.WasReplaced)
+					rewriteEnd = std::max(rewriteEnd, PeepoHappy::Crypto::Align(FArcEncryptedDataOffset + entry.TableFieldsOffset + (sizeof(u32) * 4), BlockSize));
+			}
+
+			if (rewriteEnd == FArcEncryptedDataOffset)
+				return true;
+
+			// NOTE: Read together with the IV leading it, which is rewritten as well
+			std::vector<u8> encryptedData(rewriteEnd - FArcUnencryptedHeaderSize);
+			if (!farcFile.ReadAt(FArcUnencryptedHeaderSize, encryptedData.data(), encryptedData.size()))
+				return false;
+
+			PeepoHappy::Crypto::Aes128IVBytes iv = {};
+			::memcpy(iv.data(), encryptedData.data(), iv.size());
+			u8* const encryptedBlocks = (encryptedData.data() + iv.size());
+
+			PeepoHappy::Trace::ScopedEvent encryptEvent("encrypt", rewriteEnd - FArcEncryptedDataOffset, "entry_table");
+
+			std::vector<u8> decryptedBlocks(rewriteEnd - FArcEncryptedDataOffset);
+			PeepoHappy::Crypto::DecryptAes128Cbc(encryptedBlocks, decryptedBlocks.data(), decryptedBlocks.size(), key, iv);
+
+			for (const auto& entry : entries)
+			{
+				const auto fieldBytes = GetEntryTableFields(entry, isEncrypted);
+				if (entry.WasReplaced)
+					::memcpy(decryptedBlocks.data() + entry.TableFieldsOffset, fieldBytes.data(), fieldBytes.size());
+			}
+
+			if (!PeepoHappy::Crypto::EncryptAes128CbcKeepingLastBlock(decryptedBlocks.data(), encryptedBlocks, decryptedBlocks.size(), key, iv))
+				return false;
+
+			::memcpy(encryptedData.data(), iv.data(), iv.size());
+			return farcFile.WriteAt(FArcUnencryptedHeaderSize, encryptedData.data(), encryptedData.size());
+		}
+	}
+
+	bool ReplaceFArcEntriesInPlace(std::string_view farcPath, const std::vector<FArcEntryReplacement>& replacements, const FArcUpdateSettings& settings)
+	{
+		std::vector<UpdatedEntry> entries;
+		std::unordered_map<std::string_view, size_t> entryNameIndex;
+		bool isEncrypted;
+		u32 alignment;
+		u64 reservedSize;
+
+		// NOTE: Only the entry table is decrypted, the mapping is closed again before the file is opened for writing
+		{
+			const auto farc = OpenReadDecryptAndParseFArcEntries(farcPath, nullptr, FArcDecryptMode::Lazy);
+			if (!farc.File.IsOpen() || farc.Signature == FArcSignature::Invalid || farc.EntryTableSize == 0)
+				return false;
+
+			isEncrypted = farc.Flags.Encrypted;
+			const u8* tableData = isEncrypted ? farc.DecryptedEntryTable.get() : (farc.File.Data() + FArcUnencryptedHeaderSize);
+			alignment = std::max<u32>(ByteSwapU32(*reinterpret_cast<const u32*>(tableData)), 1);
+			reservedSize = (isEncrypted ? FArcEncryptedDataOffset : FArcUnencryptedHeaderSize) + farc.EntryTableSize;
+
+			size_t tableReadOffset = (sizeof(u32) * 4);
+			entries.reserve(farc.Entries.size());
+			for (const auto& entry : farc.Entries)
+			{
+				tableReadOffset += entry.FileName.size() + sizeof('\0');
+				entries.push_back({ std::string(entry.FileName), entry.Offset, entry.CompressedSize, entry.UncompressedSize, entry.Flags, GetFArcEntryCompressionMethod(entry), tableReadOffset, false });
+				tableReadOffset += (sizeof(u32) * 4);
+			}
+		}
+
+		for (size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+			entryNameIndex.emplace(entries[entryIndex].FileName, entryIndex);
+
+		// NOTE: Checked up front as new entry data might already have overwritten the old data of other replaced entries still referenced by the entry table
+		for (const auto& replacement : replacements)
+		{
+			if (entryNameIndex.find(replacement.FileName) == entryNameIndex.end())
+			{
+				fprintf(stderr, "[ERROR] No entry named '%s' found\n", replacement.FileName.c_str());
+				return false;
+			}
+		}
+
+		PeepoHappy::IO::StreamOutputFile farcFile;
+		if (!farcFile.OpenExisting(farcPath))
+		{
+			fprintf(stderr, "[ERROR] Unable to open FArc file '%.*s' for writing\n", static_cast<int>(farcPath.size()), farcPath.data());
+			return false;
+		}
+
+		const auto key = PeepoHappy::Crypto::ParseAes128KeyHexByteString(FArcAes128KeyHexString);
+
+		for (const auto& replacement : replacements)
+		{
+			const auto foundIndex = entryNameIndex.find(replacement.FileName);
+			auto& entry = entries[foundIndex->second];
+
+			std::vector<u8> content;
+			{
+				PeepoHappy::Trace::ScopedEvent readEvent("read", 0, "source", entry.FileName);
+				if (!replacement.Source(content) || content.size() > std::numeric_limits<u32>::max())
+				{
+					fprintf(stderr, "[ERROR] Unable to read the replacement for '%s'\n", entry.FileName.c_str());
+					return false;
+				}
+				readEvent.SetByteCount(content.size());
+			}
+
+			const auto method = entry.CompressionMethod;
+			entry.Flags.SplitChunks &= (method != PeepoHappy::Compression::Method::None);
+
+			std::vector<u8> compressedData;
+			{
+				PeepoHappy::Trace::ScopedEvent compressEvent("compress", content.size(), PeepoHappy::Compression::GetMethodName(method), entry.FileName);
+				const int level = settings.CompressionLevel.value_or(GetDefaultCompressionLevel(method));
+				if (!CompressFArcEntryContent(content.data(), content.size(), method, entry.Flags.SplitChunks ? settings.SplitChunkSize : 0, level, compressedData))
+				{
+					fprintf(stderr, "[ERROR] Unable to compress the replacement for '%s'\n", entry.FileName.c_str());
+					return false;
+				}
+			}
+
+			// NOTE: Empty entries don't occupy any space and can simply stay where they are
+			const u64 dataOffset = compressedData.empty() ? entry.Offset : FindFreeEntryDataOffset(entries, foundIndex->second, reservedSize, compressedData.size(), alignment, isEncrypted);
+			if ((dataOffset + compressedData.size()) > std::numeric_limits<u32>::max())
+			{
+				fprintf(stderr, "[ERROR] Entry '%s' extends past the 4 GB limit of 32-bit entry offsets\n", entry.FileName.c_str());
+				return false;
+			}
+
+			if (!compressedData.empty())
+			{
+				PeepoHappy::Trace::ScopedEvent writeEvent("write", compressedData.size(), "farc_entry", entry.FileName);
+				if (!(isEncrypted ? WriteEncryptedEntryData(farcFile, dataOffset, compressedData, key) : WriteEntryData(farcFile, dataOffset, compressedData)))
+				{
+					fprintf(stderr, "[ERROR] Unable to write the replacement for '%s'\n", entry.FileName.c_str());
+					return false;
+				}
+			}
+
+			entry.Offset = dataOffset;
+			entry.CompressedSize = static_cast<u32>(compressedData.size());
+			entry.UncompressedSize = static_cast<u32>(content.size());
+			entry.WasReplaced = true;
+		}
+
+		// NOTE: Written last, once all of the entry data it references is in place
+		if (!WriteEntryTableFields(farcFile, entries, isEncrypted, key))
+		{
+			fprintf(stderr, "[ERROR] Unable to write the updated entry table\n");
+			return false;
+		}
+
+		return true;
+	}
+}
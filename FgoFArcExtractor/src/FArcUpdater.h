@@ -0,0 +1,33 @@
+#pragma once
+#include "Types.h"
+#include "Utilities.h"
+#include "FArc.h"
+#include "FArcBuilder.h"
+
+#include <optional>
+
+namespace FArcExtractor
+{
+	struct FArcEntryReplacement
+	{
+		std::string FileName;
+		FArcBuildEntrySource Source;
+	};
+
+	struct FArcUpdateSettings
+	{
+		// NOTE: Defaults to the DefaultGZipLevel or DefaultZStdLevel depending on the compression method of each replaced entry
+		std::optional<int> CompressionLevel;
+		// NOTE: Only used for entries already stored as split chunks. The decompressed size of each chunk is read from the chunk itself so any size will do
+		size_t SplitChunkSize = (256 * 1024);
+	};
+
+	// NOTE: Replaces the content of existing entries by only rewriting their data and their fields of the entry table, keeping each entry's compression method.
+	//		 New data is placed into the first free gap left between the other entries that it fits into (including the space freed by the entry it replaces)
+	//		 or appended to the end of the file otherwise.
+	//		 For encrypted archives only the blocks covering the new data are encrypted again, continuing the CBC chain of the block right before them.
+	//		 The block following them keeps its ciphertext and therefore has to be free space as it now decrypts to garbage.
+	//		 The modified entry table blocks are instead encrypted backwards down to the IV so that all ciphertext after them stays untouched.
+	//		 Replacing is not atomic, an interrupted update can leave the archive corrupted
+	bool ReplaceFArcEntriesInPlace(std::string_view farcPath, const std::vector<FArcEntryReplacement>& replacements, const FArcUpdateSettings& settings = {});
+}
@@ -1,17 +1,144 @@
 #include "Utilities.h"
 
+#include <intrin.h>
+#include <wmmintrin.h>
+#include <immintrin.h>
+#include <new>
+#include <map>
+
 #define NOMINMAX
 #include <Windows.h>
-#include <bcrypt.h>
-
-#ifndef  NT_SUCCESS
-#define NT_SUCCESS(Status) (((::NTSTATUS)(Status)) >= 0)
-#endif // ! NT_SUCCESS
-
-#pragma comment(lib, "bcrypt.lib")
 
 namespace PeepoHappy
 {
+	namespace ASCII
+	{
+		namespace
+		{
+			inline __m128i ToLowerCaseSSE2(__m128i characters)
+			{
+				const __m128i isUpperCase = _mm_and_si128(_mm_cmpgt_epi8(characters, _mm_set1_epi8(UpperCaseMin - 1)), _mm_cmplt_epi8(characters, _mm_set1_epi8(UpperCaseMax + 1)));
+				return _mm_or_si128(characters, _mm_and_si128(isUpperCase, _mm_set1_epi8(-CaseDifference)));
+			}
+
+			// NOTE: Compares a single glob segment without any '*' in it, the common case of no '?' takes the vectorized path
+			bool MatchesGlobSegmentInsensitive(std::string_view s, std::string_view segment)
+			{
+				if (segment.find('?') == std::string_view::npos)
+					return MatchesInsensitive(s, segment);
+
+				if (s.size() != segment.size())
+					return false;
+
+				for (size_t i = 0; i < segment.size(); i++)
+				{
+					if (segment[i] != '?' && !CaseInsenitiveComparison(s[i], segment[i]))
+						return false;
+				}
+				return true;
+			}
+		}
+
+		bool MatchesInsensitive(std::string_view a, std::string_view b)
+		{
+			if (a.size() != b.size())
+				return false;
+
+			constexpr size_t vectorSize = sizeof(__m128i);
+
+			size_t i = 0;
+			for (; i + vectorSize <= a.size(); i += vectorSize)
+			{
+				const __m128i lowerA = ToLowerCaseSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i)));
+				const __m128i lowerB = ToLowerCaseSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + i)));
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(lowerA, lowerB)) != 0xFFFF)
+					return false;
+			}
+
+			for (; i < a.size(); i++)
+			{
+				if (!CaseInsenitiveComparison(a[i], b[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		bool MatchesGlobInsensitive(std::string_view s, std::string_view globPattern)
+		{
+			const size_t firstStar = globPattern.find('*');
+			if (firstStar == std::string_view::npos)
+				return MatchesGlobSegmentInsensitive(s, globPattern);
+
+			const size_t lastStar = globPattern.rfind('*');
+			const auto prefix = globPattern.substr(0, firstStar);
+			const auto suffix = globPattern.substr(lastStar + 1);
+
+			if (s.size() < (prefix.size() + suffix.size()))
+				return false;
+			if (!MatchesGlobSegmentInsensitive(s.substr(0, prefix.size()), prefix) || !MatchesGlobSegmentInsensitive(s.substr(s.size() - suffix.size()), suffix))
+				return false;
+
+			// NOTE: Greedily match every segment between the first and last star at its earliest possible position
+			auto remaining = s.substr(prefix.size(), s.size() - prefix.size() - suffix.size());
+			auto middle = globPattern.substr(firstStar + 1, (lastStar > firstStar) ? (lastStar - firstStar - 1) : 0);
+
+			while (!middle.empty())
+			{
+				const size_t nextStar = middle.find('*');
+				const auto segment = middle.substr(0, nextStar);
+				middle = (nextStar == std::string_view::npos) ? std::string_view() : middle.substr(nextStar + 1);
+
+				if (segment.empty())
+					continue;
+
+				bool segmentFound = false;
+				for (size_t offset = 0; offset + segment.size() <= remaining.size(); offset++)
+				{
+					if (MatchesGlobSegmentInsensitive(remaining.substr(offset, segment.size()), segment))
+					{
+						remaining = remaining.substr(offset + segment.size());
+						segmentFound = true;
+						break;
+					}
+				}
+
+				if (!segmentFound)
+					return false;
+			}
+
+			return true;
+		}
+	}
+
+	namespace JSON
+	{
+		void AppendEscapedString(std::string& outString, std::string_view value)
+		{
+			outString.push_back('"');
+			for (const char c : value)
+			{
+				if (c == '"' || c == '\\')
+				{
+					outString.push_back('\\');
+					outString.push_back(c);
+				}
+				else if (static_cast<u8>(c) < 0x20)
+				{
+					char escapeBuffer[8];
+					snprintf(escapeBuffer, sizeof(escapeBuffer), "\\u%04X", static_cast<u32>(static_cast<u8>(c)));
+					outString.append(escapeBuffer);
+				}
+				else
+				{
+					outString.push_back(c);
+				}
+			}
+			outString.push_back('"');
+		}
+	}
+
 	namespace UTF8
 	{
 		std::string Narrow(std::wstring_view inputString)
@@ -164,6 +291,62 @@ namespace PeepoHappy
 			::CreateDirectoryW(UTF8::WideArg(directoryPath).c_str(), 0);
 		}
 
+		bool FileExists(std::string_view filePath)
+		{
+			const DWORD attributes = ::GetFileAttributesW(UTF8::WideArg(filePath).c_str());
+			return (attributes != INVALID_FILE_ATTRIBUTES) && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+		}
+
+		bool DirectoryExists(std::string_view directoryPath)
+		{
+			const DWORD attributes = ::GetFileAttributesW(UTF8::WideArg(directoryPath).c_str());
+			return (attributes != INVALID_FILE_ATTRIBUTES) && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+		}
+
+		u64 GetFileSize(std::string_view filePath)
+		{
+			::WIN32_FILE_ATTRIBUTE_DATA attributeData = {};
+			if (!::GetFileAttributesExW(UTF8::WideArg(filePath).c_str(), GetFileExInfoStandard, &attributeData))
+				return 0;
+
+			return (static_cast<u64>(attributeData.nFileSizeHigh) << 32) | static_cast<u64>(attributeData.nFileSizeLow);
+		}
+
+		u64 GetFileLastWriteTime(std::string_view filePath)
+		{
+			::WIN32_FILE_ATTRIBUTE_DATA attributeData = {};
+			if (!::GetFileAttributesExW(UTF8::WideArg(filePath).c_str(), GetFileExInfoStandard, &attributeData))
+				return 0;
+
+			return (static_cast<u64>(attributeData.ftLastWriteTime.dwHighDateTime) << 32) | static_cast<u64>(attributeData.ftLastWriteTime.dwLowDateTime);
+		}
+
+		std::vector<std::string> GetFilesInDirectory(std::string_view directoryPath)
+		{
+			std::vector<std::string> filePaths;
+
+			std::string searchPattern;
+			searchPattern.reserve(directoryPath.size() + 2);
+			searchPattern.append(directoryPath).append("/*");
+
+			::WIN32_FIND_DATAW findData = {};
+			::HANDLE findHandle = ::FindFirstFileW(UTF8::WideArg(searchPattern).c_str(), &findData);
+			if (findHandle == INVALID_HANDLE_VALUE)
+				return filePaths;
+
+			do
+			{
+				if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					continue;
+
+				filePaths.emplace_back(directoryPath).append("/").append(UTF8::Narrow(findData.cFileName));
+			}
+			while (::FindNextFileW(findHandle, &findData));
+
+			::FindClose(findHandle);
+			return filePaths;
+		}
+
 		std::pair<std::unique_ptr<u8[]>, size_t> ReadEntireFile(std::string_view filePath)
 		{
 			std::unique_ptr<u8[]> fileContent = nullptr;
@@ -194,7 +377,7 @@ namespace PeepoHappy
 
 		bool WriteEntireFile(std::string_view filePath, const u8* fileContent, size_t fileSize)
 		{
-			if (filePath.empty() || fileContent == nullptr || fileSize == 0)
+			if (filePath.empty() || (fileContent == nullptr && fileSize != 0))
 				return false;
 
 			::HANDLE fileHandle = ::CreateFileW(UTF8::WideArg(filePath).c_str(), GENERIC_WRITE, (FILE_SHARE_READ | FILE_SHARE_WRITE), NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
@@ -204,135 +387,1729 @@ namespace PeepoHappy
 			assert(fileSize < std::numeric_limits<DWORD>::max() && "No way that's ever gonna happen, right?");
 
 			DWORD bytesWritten = 0;
-			::WriteFile(fileHandle, fileContent, static_cast<DWORD>(fileSize), &bytesWritten, nullptr);
+			const bool wasSuccessful = (fileSize == 0) || (::WriteFile(fileHandle, fileContent, static_cast<DWORD>(fileSize), &bytesWritten, nullptr) && bytesWritten == fileSize);
 
 			::CloseHandle(fileHandle);
-			return true;
+			return wasSuccessful;
 		}
-	}
 
-	namespace Crypto
-	{
-		namespace Detail
+		bool RemoveFile(std::string_view filePath)
+		{
+			return ::DeleteFileW(UTF8::WideArg(filePath).c_str());
+		}
+
+		bool RenameFile(std::string_view sourceFilePath, std::string_view destinationFilePath)
+		{
+			return ::MoveFileExW(UTF8::WideArg(sourceFilePath).c_str(), UTF8::WideArg(destinationFilePath).c_str(), 0);
+		}
+
+		bool CreateFileHardLink(std::string_view linkFilePath, std::string_view existingFilePath)
+		{
+			return ::CreateHardLinkW(UTF8::WideArg(linkFilePath).c_str(), UTF8::WideArg(existingFilePath).c_str(), NULL);
+		}
+
+		MappedFile::MappedFile(MappedFile&& other)
 		{
-			enum class Operation { Decrypt, Encrypt };
+			*this = std::move(other);
+		}
 
-			bool BCryptAes128Cbc(Operation operation, const u8* inData, size_t inDataSize, u8* outData, size_t outDataSize, u8* key, u8* iv)
+		MappedFile& MappedFile::operator=(MappedFile&& other)
+		{
+			if (this != &other)
 			{
-				bool successful = false;
-				::NTSTATUS status = {};
-				::BCRYPT_ALG_HANDLE algorithmHandle = {};
+				Close();
+				std::swap(fileHandle, other.fileHandle);
+				std::swap(mappingHandle, other.mappingHandle);
+				std::swap(viewData, other.viewData);
+				std::swap(viewSize, other.viewSize);
+			}
+			return *this;
+		}
 
-				status = ::BCryptOpenAlgorithmProvider(&algorithmHandle, BCRYPT_AES_ALGORITHM, nullptr, 0);
-				if (NT_SUCCESS(status))
-				{
-					status = ::BCryptSetProperty(algorithmHandle, BCRYPT_CHAINING_MODE, reinterpret_cast<PBYTE>(const_cast<wchar_t*>(BCRYPT_CHAIN_MODE_CBC)), sizeof(BCRYPT_CHAIN_MODE_CBC), 0);
-					if (NT_SUCCESS(status))
-					{
-						ULONG keyObjectSize = {};
-						ULONG copiedDataSize = {};
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
 
-						status = ::BCryptGetProperty(algorithmHandle, BCRYPT_OBJECT_LENGTH, reinterpret_cast<PBYTE>(&keyObjectSize), sizeof(ULONG), &copiedDataSize, 0);
-						if (NT_SUCCESS(status))
-						{
-							::BCRYPT_KEY_HANDLE symmetricKeyHandle = {};
-							auto keyObject = std::make_unique<u8[]>(keyObjectSize);
-
-							status = ::BCryptGenerateSymmetricKey(algorithmHandle, &symmetricKeyHandle, keyObject.get(), keyObjectSize, key, static_cast<ULONG>(Aes128KeySize), 0);
-							if (NT_SUCCESS(status))
-							{
-								if (operation == Operation::Decrypt)
-								{
-									status = ::BCryptDecrypt(symmetricKeyHandle, const_cast<u8*>(inData), static_cast<ULONG>(inDataSize), nullptr, iv, static_cast<ULONG>(Aes128IVSize), outData, static_cast<ULONG>(outDataSize), &copiedDataSize, 0);
-									if (NT_SUCCESS(status))
-										successful = true;
-									else
-										fprintf(stderr, "BCryptDecrypt() failed with 0x%X\n", status);
-								}
-								else if (operation == Operation::Encrypt)
-								{
-									status = ::BCryptEncrypt(symmetricKeyHandle, const_cast<u8*>(inData), static_cast<ULONG>(inDataSize), nullptr, iv, static_cast<ULONG>(Aes128IVSize), outData, static_cast<ULONG>(outDataSize), &copiedDataSize, 0);
-									if (NT_SUCCESS(status))
-										successful = true;
-									else
-										fprintf(stderr, "BCryptEncrypt() failed with 0x%X\n", status);
-								}
-								else
-								{
-									assert(false);
-								}
-
-								if (symmetricKeyHandle)
-									::BCryptDestroyKey(symmetricKeyHandle);
-							}
-							else
-							{
-								fprintf(stderr, "BCryptGenerateSymmetricKey() failed with 0x%X\n", status);
-							}
-						}
-						else
-						{
-							fprintf(stderr, "BCryptGetProperty(BCRYPT_OBJECT_LENGTH) failed with 0x%X\n", status);
-						}
-					}
-					else
-					{
-						fprintf(stderr, "BCryptSetProperty(BCRYPT_CHAINING_MODE) failed with 0x%X\n", status);
-					}
+		bool MappedFile::Open(std::string_view filePath)
+		{
+			Close();
 
-					if (algorithmHandle)
-						::BCryptCloseAlgorithmProvider(algorithmHandle, 0);
-				}
-				else
-				{
-					fprintf(stderr, "BCryptOpenAlgorithmProvider(BCRYPT_AES_ALGORITHM) failed with 0x%X\n", status);
-				}
+			fileHandle = ::CreateFileW(UTF8::WideArg(filePath).c_str(), GENERIC_READ, (FILE_SHARE_READ | FILE_SHARE_WRITE), NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				fileHandle = nullptr;
+				return false;
+			}
+
+			::LARGE_INTEGER largeIntegerFileSize = {};
+			::GetFileSizeEx(fileHandle, &largeIntegerFileSize);
+
+			// NOTE: Empty files can't be mapped so treat them the same as missing ones
+			if (largeIntegerFileSize.QuadPart <= 0)
+			{
+				Close();
+				return false;
+			}
+
+			mappingHandle = ::CreateFileMappingW(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mappingHandle == nullptr)
+			{
+				Close();
+				return false;
+			}
 
-				return successful;
+			viewData = static_cast<u8*>(::MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0));
+			if (viewData == nullptr)
+			{
+				Close();
+				return false;
 			}
+
+			viewSize = static_cast<size_t>(largeIntegerFileSize.QuadPart);
+			return true;
 		}
 
-		bool DecryptAes128Cbc(const u8* inEncryptedData, u8* outDecryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv)
+		void MappedFile::Close()
 		{
-			return Detail::BCryptAes128Cbc(Detail::Operation::Decrypt, inEncryptedData, inOutDataSize, outDecryptedData, inOutDataSize, key.data(), iv.data());
+			if (viewData != nullptr)
+				::UnmapViewOfFile(viewData);
+			if (mappingHandle != nullptr)
+				::CloseHandle(mappingHandle);
+			if (fileHandle != nullptr)
+				::CloseHandle(fileHandle);
+
+			fileHandle = nullptr;
+			mappingHandle = nullptr;
+			viewData = nullptr;
+			viewSize = 0;
 		}
 
-		bool EncryptAes128Cbc(const u8* inDecryptedData, u8* outEncryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv)
+		bool MappedFile::IsOpen() const
 		{
-			assert(Align(inOutDataSize, Aes128Alignment) == inOutDataSize);
-			return Detail::BCryptAes128Cbc(Detail::Operation::Encrypt, inDecryptedData, inOutDataSize, outEncryptedData, inOutDataSize, key.data(), iv.data());
+			return (viewData != nullptr);
 		}
 
-		Aes128KeyBytes ParseAes128KeyHexByteString(std::string_view hexByteString)
+		u8* MappedFile::Data() const
 		{
-			constexpr size_t hexDigitsPerByte = 2;
+			return viewData;
+		}
 
-			char upperCaseHexChars[(Aes128KeySize * hexDigitsPerByte) + sizeof('\0')] = {};
-			size_t hexCharsWrittenSoFar = 0;
+		size_t MappedFile::Size() const
+		{
+			return viewSize;
+		}
 
-			for (size_t charIndex = 0; charIndex < hexByteString.size(); charIndex++)
+		MappedOutputFile::~MappedOutputFile()
+		{
+			Close();
+		}
+
+		bool MappedOutputFile::Create(std::string_view filePath, size_t fileSize)
+		{
+			Close();
+
+			path = filePath;
+			committed = false;
+
+			fileHandle = ::CreateFileW(UTF8::WideArg(filePath).c_str(), (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
 			{
-				if (ASCII::IsWhiteSpace(hexByteString[charIndex]))
-					continue;
+				fileHandle = nullptr;
+				return false;
+			}
 
-				const char upperCaseChar = ASCII::ToUpperCase(hexByteString[charIndex]);
-				upperCaseHexChars[hexCharsWrittenSoFar++] = ((upperCaseChar >= '0' && upperCaseChar <= '9') || (upperCaseChar >= 'A' && upperCaseChar <= 'F')) ? upperCaseChar : '0';
+			// NOTE: Empty files can't be mapped but there also isn't anything to write into them
+			if (fileSize == 0)
+				return true;
 
-				if (hexCharsWrittenSoFar >= std::size(upperCaseHexChars))
-					break;
+			::LARGE_INTEGER largeIntegerFileSize = {};
+			largeIntegerFileSize.QuadPart = static_cast<LONGLONG>(fileSize);
+			if (!::SetFilePointerEx(fileHandle, largeIntegerFileSize, nullptr, FILE_BEGIN) || !::SetEndOfFile(fileHandle))
+			{
+				Close();
+				return false;
 			}
 
-			Aes128KeyBytes resultKeyBytes = {};
-			for (size_t byteIndex = 0; byteIndex < resultKeyBytes.size(); byteIndex++)
+			mappingHandle = ::CreateFileMappingW(fileHandle, NULL, PAGE_READWRITE, static_cast<DWORD>(static_cast<u64>(fileSize) >> 32), static_cast<DWORD>(fileSize), nullptr);
+			if (mappingHandle == nullptr)
 			{
-				auto upperCaseHexCharToNibble = [](char c) -> u8 { return (c >= '0' && c <= '9') ? (c - '0') : (c >= 'A' && c <= 'F') ? (0xA + (c - 'A')) : 0x0; };
+				Close();
+				return false;
+			}
 
-				u8 combinedByte = 0x00;
-				combinedByte |= (upperCaseHexCharToNibble(upperCaseHexChars[(byteIndex * hexDigitsPerByte) + 0]) << 4);
-				combinedByte |= (upperCaseHexCharToNibble(upperCaseHexChars[(byteIndex * hexDigitsPerByte) + 1]) << 0);
-				resultKeyBytes[byteIndex] = combinedByte;
+			viewData = static_cast<u8*>(::MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, fileSize));
+			if (viewData == nullptr)
+			{
+				Close();
+				return false;
 			}
-			return resultKeyBytes;
+
+			viewSize = fileSize;
+			return true;
+		}
+
+		bool MappedOutputFile::Commit()
+		{
+			if (fileHandle == nullptr)
+				return false;
+
+			committed = true;
+			Close();
+			return true;
+		}
+
+		void MappedOutputFile::Close()
+		{
+			if (viewData != nullptr)
+				::UnmapViewOfFile(viewData);
+			if (mappingHandle != nullptr)
+				::CloseHandle(mappingHandle);
+			if (fileHandle != nullptr)
+				::CloseHandle(fileHandle);
+
+			if (fileHandle != nullptr && !committed)
+				::DeleteFileW(UTF8::WideArg(path).c_str());
+
+			fileHandle = nullptr;
+			mappingHandle = nullptr;
+			viewData = nullptr;
+			viewSize = 0;
+		}
+
+		u8* MappedOutputFile::Data() const
+		{
+			return viewData;
+		}
+
+		size_t MappedOutputFile::Size() const
+		{
+			return viewSize;
+		}
+
+		StreamOutputFile::~StreamOutputFile()
+		{
+			Close();
+		}
+
+		bool StreamOutputFile::Create(std::string_view filePath)
+		{
+			Close();
+
+			path = filePath;
+			fileSize = 0;
+			committed = false;
+
+			fileHandle = ::CreateFileW(UTF8::WideArg(filePath).c_str(), (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				fileHandle = nullptr;
+				return false;
+			}
+
+			return true;
+		}
+
+		bool StreamOutputFile::OpenExisting(std::string_view filePath)
+		{
+			Close();
+
+			path = filePath;
+			fileSize = 0;
+			committed = true;
+
+			fileHandle = ::CreateFileW(UTF8::WideArg(filePath).c_str(), (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				fileHandle = nullptr;
+				return false;
+			}
+
+			::LARGE_INTEGER largeIntegerFileSize = {};
+			::GetFileSizeEx(fileHandle, &largeIntegerFileSize);
+			fileSize = static_cast<u64>(largeIntegerFileSize.QuadPart);
+			return true;
+		}
+
+		bool StreamOutputFile::Commit()
+		{
+			if (fileHandle == nullptr)
+				return false;
+
+			committed = true;
+			Close();
+			return true;
+		}
+
+		void StreamOutputFile::Close()
+		{
+			if (fileHandle != nullptr)
+				::CloseHandle(fileHandle);
+
+			if (fileHandle != nullptr && !committed)
+				::DeleteFileW(UTF8::WideArg(path).c_str());
+
+			fileHandle = nullptr;
+			fileSize = 0;
+		}
+
+		bool StreamOutputFile::Write(const u8* data, size_t dataSize)
+		{
+			return WriteAt(fileSize, data, dataSize);
+		}
+
+		bool StreamOutputFile::WriteAt(u64 fileOffset, const u8* data, size_t dataSize)
+		{
+			if (fileHandle == nullptr || !SeekTo(fileOffset))
+				return false;
+
+			// NOTE: Split up into smaller writes as a single WriteFile() call is limited to a DWORD byte count
+			constexpr size_t maxWriteSize = (1024 * 1024 * 1024);
+			for (size_t writtenSize = 0; writtenSize < dataSize;)
+			{
+				const DWORD writeSize = static_cast<DWORD>(std::min(dataSize - writtenSize, maxWriteSize));
+				DWORD bytesWritten = 0;
+				if (!::WriteFile(fileHandle, data + writtenSize, writeSize, &bytesWritten, nullptr) || bytesWritten != writeSize)
+					return false;
+				writtenSize += writeSize;
+			}
+
+			fileSize = std::max(fileSize, fileOffset + dataSize);
+			return true;
+		}
+
+		bool StreamOutputFile::ReadAt(u64 fileOffset, u8* outData, size_t dataSize)
+		{
+			if (fileHandle == nullptr || (fileOffset + dataSize) > fileSize || !SeekTo(fileOffset))
+				return false;
+
+			constexpr size_t maxReadSize = (1024 * 1024 * 1024);
+			for (size_t readSize = 0; readSize < dataSize;)
+			{
+				const DWORD chunkSize = static_cast<DWORD>(std::min(dataSize - readSize, maxReadSize));
+				DWORD bytesRead = 0;
+				if (!::ReadFile(fileHandle, outData + readSize, chunkSize, &bytesRead, nullptr) || bytesRead != chunkSize)
+					return false;
+				readSize += chunkSize;
+			}
+
+			return true;
+		}
+
+		u64 StreamOutputFile::Size() const
+		{
+			return fileSize;
+		}
+
+		bool StreamOutputFile::SeekTo(u64 fileOffset)
+		{
+			::LARGE_INTEGER largeIntegerFileOffset = {};
+			largeIntegerFileOffset.QuadPart = static_cast<LONGLONG>(fileOffset);
+			return ::SetFilePointerEx(fileHandle, largeIntegerFileOffset, nullptr, FILE_BEGIN);
+		}
+	}
+
+	namespace Memory
+	{
+		namespace
+		{
+			u8* AllocateAligned(size_t byteSize)
+			{
+				return static_cast<u8*>(::operator new(byteSize, std::align_val_t(CacheLineSize)));
+			}
+
+			void FreeAligned(u8* buffer)
+			{
+				::operator delete(buffer, std::align_val_t(CacheLineSize));
+			}
+		}
+
+		void PooledBufferDeleter::operator()(u8* buffer) const
+		{
+			if (Pool != nullptr)
+				Pool->Release(buffer, ByteSize);
+		}
+
+		BufferPool::~BufferPool()
+		{
+			for (size_t sizeClassIndex = 0; sizeClassIndex < freeLists.size(); sizeClassIndex++)
+			{
+				if (!IsSlabSizeClass(sizeClassIndex))
+				{
+					for (u8* buffer : freeLists[sizeClassIndex])
+						FreeAligned(buffer);
+				}
+			}
+
+			for (u8* slab : slabs)
+				FreeAligned(slab);
+		}
+
+		PooledBuffer BufferPool::Allocate(size_t byteSize)
+		{
+			const size_t sizeClassIndex = GetSizeClassIndex(byteSize);
+			if (sizeClassIndex >= freeLists.size())
+				return PooledBuffer(AllocateAligned(byteSize), PooledBufferDeleter { this, byteSize });
+
+			const size_t sizeClassSize = GetSizeClassSize(sizeClassIndex);
+
+			std::unique_lock lock(mutex);
+
+			// NOTE: The deleter is given the size class of the buffer itself rather than the requested size so it is always returned to the free list it was taken from
+			const size_t lastReusableSizeClassIndex = std::min(sizeClassIndex + MaxSizeClassReuseSteps, freeLists.size() - 1);
+			for (size_t reusableSizeClassIndex = sizeClassIndex; reusableSizeClassIndex <= lastReusableSizeClassIndex; reusableSizeClassIndex++)
+			{
+				if (auto& freeList = freeLists[reusableSizeClassIndex]; !freeList.empty())
+				{
+					u8* recycledBuffer = freeList.back();
+					freeList.pop_back();
+
+					const size_t recycledBufferSize = GetSizeClassSize(reusableSizeClassIndex);
+					if (!IsSlabSizeClass(reusableSizeClassIndex))
+						retainedFreeByteSize -= recycledBufferSize;
+					return PooledBuffer(recycledBuffer, PooledBufferDeleter { this, recycledBufferSize });
+				}
+			}
+
+			if (!IsSlabSizeClass(sizeClassIndex))
+			{
+				lock.unlock();
+				return PooledBuffer(AllocateAligned(sizeClassSize), PooledBufferDeleter { this, sizeClassSize });
+			}
+
+			// NOTE: Whatever is left at the end of the previous slab is simply abandoned, at most one max slab size class per slab
+			if (slabRemainingSize < sizeClassSize)
+			{
+				slabHead = slabs.emplace_back(AllocateAligned(SlabSize));
+				slabRemainingSize = SlabSize;
+			}
+
+			u8* slabBuffer = slabHead;
+			slabHead += sizeClassSize;
+			slabRemainingSize -= sizeClassSize;
+			return PooledBuffer(slabBuffer, PooledBufferDeleter { this, sizeClassSize });
+		}
+
+		void BufferPool::Release(u8* buffer, size_t byteSize)
+		{
+			if (buffer == nullptr)
+				return;
+
+			const size_t sizeClassIndex = GetSizeClassIndex(byteSize);
+			if (sizeClassIndex >= freeLists.size())
+			{
+				FreeAligned(buffer);
+				return;
+			}
+
+			{
+				std::scoped_lock lock(mutex);
+				if (IsSlabSizeClass(sizeClassIndex))
+				{
+					freeLists[sizeClassIndex].push_back(buffer);
+					return;
+				}
+
+				const size_t sizeClassSize = GetSizeClassSize(sizeClassIndex);
+				if (retainedFreeByteSize + sizeClassSize <= MaxRetainedFreeByteSize)
+				{
+					freeLists[sizeClassIndex].push_back(buffer);
+					retainedFreeByteSize += sizeClassSize;
+					return;
+				}
+			}
+
+			FreeAligned(buffer);
+		}
+
+		size_t BufferPool::GetSizeClassIndex(size_t byteSize)
+		{
+			size_t sizeClassShift = MinSizeClassShift;
+			while ((static_cast<size_t>(1) << sizeClassShift) < byteSize && sizeClassShift <= MaxSizeClassShift)
+				sizeClassShift++;
+			return (sizeClassShift - MinSizeClassShift);
+		}
+
+		size_t BufferPool::GetSizeClassSize(size_t sizeClassIndex)
+		{
+			return (static_cast<size_t>(1) << (sizeClassIndex + MinSizeClassShift));
+		}
+
+		bool BufferPool::IsSlabSizeClass(size_t sizeClassIndex)
+		{
+			return ((sizeClassIndex + MinSizeClassShift) <= MaxSlabSizeClassShift);
+		}
+	}
+
+	namespace Threading
+	{
+		u32 GetHardwareThreadCount()
+		{
+			return std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		ThreadPool::ThreadPool(u32 threadCount)
+		{
+			workerThreads.reserve(std::max(threadCount, 1u));
+			for (u32 i = 0; i < std::max(threadCount, 1u); i++)
+				workerThreads.emplace_back([this] { WorkerThreadLoop(); });
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::scoped_lock lock(queueMutex);
+				shutdownRequested = true;
+			}
+			taskAvailableCondition.notify_all();
+
+			for (auto& thread : workerThreads)
+				thread.join();
+		}
+
+		void ThreadPool::Enqueue(std::function<void()> task)
+		{
+			{
+				std::scoped_lock lock(queueMutex);
+				taskQueue.push_back(QueuedTask { std::move(task), nullptr });
+			}
+			taskAvailableCondition.notify_one();
+		}
+
+		void ThreadPool::Enqueue(TaskGroup& group, std::function<void()> task)
+		{
+			{
+				std::scoped_lock lock(queueMutex);
+				taskQueue.push_back(QueuedTask { std::move(task), &group });
+				group.PendingTaskCount++;
+			}
+			taskAvailableCondition.notify_one();
+		}
+
+		void ThreadPool::WaitUntilIdle()
+		{
+			std::unique_lock lock(queueMutex);
+			taskFinishedCondition.wait(lock, [this] { return taskQueue.empty() && runningTaskCount == 0; });
+		}
+
+		void ThreadPool::Wait(TaskGroup& group)
+		{
+			std::unique_lock lock(queueMutex);
+			while (group.PendingTaskCount > 0)
+			{
+				if (taskQueue.empty())
+				{
+					taskFinishedCondition.wait(lock);
+					continue;
+				}
+
+				QueuedTask task = std::move(taskQueue.front());
+				taskQueue.pop_front();
+				RunDequeuedTask(task, lock);
+			}
+		}
+
+		u32 ThreadPool::GetThreadCount() const
+		{
+			return static_cast<u32>(workerThreads.size());
+		}
+
+		void ThreadPool::WorkerThreadLoop()
+		{
+			std::unique_lock lock(queueMutex);
+			while (true)
+			{
+				taskAvailableCondition.wait(lock, [this] { return shutdownRequested || !taskQueue.empty(); });
+
+				if (shutdownRequested && taskQueue.empty())
+					return;
+
+				QueuedTask task = std::move(taskQueue.front());
+				taskQueue.pop_front();
+				RunDequeuedTask(task, lock);
+			}
+		}
+
+		void ThreadPool::RunDequeuedTask(QueuedTask& task, std::unique_lock<std::mutex>& lock)
+		{
+			runningTaskCount++;
+			lock.unlock();
+
+			task.Function();
+
+			lock.lock();
+			runningTaskCount--;
+			if (task.Group != nullptr)
+				task.Group->PendingTaskCount--;
+
+			taskFinishedCondition.notify_all();
+		}
+
+		ByteBudget::ByteBudget(size_t maxBytes) : maxBytes(maxBytes)
+		{
+		}
+
+		void ByteBudget::Acquire(size_t byteSize)
+		{
+			std::unique_lock lock(mutex);
+			releasedCondition.wait(lock, [&] { return (inFlightBytes == 0) || (inFlightBytes + byteSize <= maxBytes); });
+
+			inFlightBytes += byteSize;
+			peakBytes = std::max(peakBytes, inFlightBytes);
+		}
+
+		void ByteBudget::Release(size_t byteSize)
+		{
+			{
+				std::scoped_lock lock(mutex);
+				assert(inFlightBytes >= byteSize);
+				inFlightBytes -= byteSize;
+			}
+			releasedCondition.notify_all();
+		}
+
+		size_t ByteBudget::GetMaxBytes() const
+		{
+			return maxBytes;
+		}
+
+		size_t ByteBudget::GetPeakBytes() const
+		{
+			std::scoped_lock lock(mutex);
+			return peakBytes;
+		}
+	}
+
+	namespace Trace
+	{
+		namespace
+		{
+			struct ThreadEventList
+			{
+				u32 ThreadID;
+				std::vector<Event> Events;
+			};
+
+			std::mutex GlobalThreadEventListsMutex;
+			std::vector<std::unique_ptr<ThreadEventList>> GlobalThreadEventLists;
+			i64 GlobalEnableTicks = 0;
+			u32 GlobalMainThreadID = 0;
+
+			ThreadEventList& GetCurrentThreadEventList()
+			{
+				thread_local ThreadEventList* threadEventList = nullptr;
+				if (threadEventList == nullptr)
+				{
+					std::scoped_lock lock(GlobalThreadEventListsMutex);
+					threadEventList = GlobalThreadEventLists.emplace_back(std::make_unique<ThreadEventList>()).get();
+					threadEventList->ThreadID = static_cast<u32>(::GetCurrentThreadId());
+				}
+				return *threadEventList;
+			}
+
+			f64 GetTicksPerMicrosecond()
+			{
+				LARGE_INTEGER frequency = {};
+				::QueryPerformanceFrequency(&frequency);
+				return static_cast<f64>(frequency.QuadPart) / 1000000.0;
+			}
+		}
+
+		void Enable()
+		{
+			GlobalEnableTicks = GetTimestampTicks();
+			GlobalMainThreadID = static_cast<u32>(::GetCurrentThreadId());
+			GlobalIsEnabled = true;
+		}
+
+		i64 GetTimestampTicks()
+		{
+			LARGE_INTEGER counter = {};
+			::QueryPerformanceCounter(&counter);
+			return counter.QuadPart;
+		}
+
+		void RecordEvent(Event&& event)
+		{
+			GetCurrentThreadEventList().Events.push_back(std::move(event));
+		}
+
+		bool WriteChromeTraceJson(std::string_view filePath)
+		{
+			const f64 ticksPerMicrosecond = GetTicksPerMicrosecond();
+			char formatBuffer[192];
+
+			std::string json;
+			json.append("{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+			std::scoped_lock lock(GlobalThreadEventListsMutex);
+			bool isFirstEvent = true;
+
+			for (const auto& threadEventList : GlobalThreadEventLists)
+			{
+				snprintf(formatBuffer, sizeof(formatBuffer), "%s\n  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": { \"name\": \"%s %u\" } }",
+					isFirstEvent ? "" : ",", threadEventList->ThreadID, (threadEventList->ThreadID == GlobalMainThreadID) ? "Main Thread" : "Worker Thread", threadEventList->ThreadID);
+				json.append(formatBuffer);
+				isFirstEvent = false;
+
+				for (const auto& event : threadEventList->Events)
+				{
+					json.append(",\n  { \"name\": ");
+					JSON::AppendEscapedString(json, event.Label.empty() ? event.Stage : event.Label);
+					json.append(", \"cat\": ");
+					JSON::AppendEscapedString(json, (event.Detail != nullptr) ? event.Detail : event.Stage);
+
+					snprintf(formatBuffer, sizeof(formatBuffer), ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": { \"stage\": \"%s\", \"bytes\": %llu } }",
+						static_cast<f64>(event.StartTicks - GlobalEnableTicks) / ticksPerMicrosecond, static_cast<f64>(event.EndTicks - event.StartTicks) / ticksPerMicrosecond,
+						threadEventList->ThreadID, event.Stage, static_cast<unsigned long long>(event.ByteCount));
+					json.append(formatBuffer);
+				}
+			}
+
+			json.append("\n] }\n");
+			return IO::WriteEntireFile(filePath, reinterpret_cast<const u8*>(json.data()), json.size());
+		}
+
+		void PrintThroughputSummary()
+		{
+			struct StageSummary
+			{
+				size_t EventCount = 0;
+				u64 ByteCount = 0;
+				i64 BusyTicks = 0;
+				i64 FirstStartTicks = std::numeric_limits<i64>::max();
+				i64 LastEndTicks = std::numeric_limits<i64>::min();
+			};
+
+			// NOTE: Keyed on stage and detail with an empty detail for the total of each stage, which conveniently sorts right before its details
+			std::map<std::pair<std::string_view, std::string_view>, StageSummary> stageSummaries;
+
+			std::scoped_lock lock(GlobalThreadEventListsMutex);
+			for (const auto& threadEventList : GlobalThreadEventLists)
+			{
+				for (const auto& event : threadEventList->Events)
+				{
+					for (const std::string_view detail : { std::string_view(""), std::string_view((event.Detail != nullptr) ? event.Detail : "") })
+					{
+						auto& summary = stageSummaries[std::make_pair(std::string_view(event.Stage), detail)];
+						summary.EventCount++;
+						summary.ByteCount += event.ByteCount;
+						summary.BusyTicks += (event.EndTicks - event.StartTicks);
+						summary.FirstStartTicks = std::min(summary.FirstStartTicks, event.StartTicks);
+						summary.LastEndTicks = std::max(summary.LastEndTicks, event.EndTicks);
+
+						if (event.Detail == nullptr)
+							break;
+					}
+				}
+			}
+
+			const f64 ticksPerMicrosecond = GetTicksPerMicrosecond();
+			auto toMilliseconds = [&](i64 ticks) { return static_cast<f64>(ticks) / ticksPerMicrosecond / 1000.0; };
+			auto toMegabytesPerSecond = [](u64 byteCount, f64 milliseconds) { return (milliseconds > 0.0) ? (static_cast<f64>(byteCount) / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0; };
+
+			fprintf(stderr, "%-24s %10s %12s %12s %12s %12s %12s\n", "Stage", "Count", "MB", "Busy ms", "Wall ms", "Busy MB/s", "Wall MB/s");
+			for (const auto&[key, summary] : stageSummaries)
+			{
+				const auto&[stage, detail] = key;
+				char nameBuffer[64];
+				if (detail.empty())
+					snprintf(nameBuffer, sizeof(nameBuffer), "%.*s", static_cast<int>(stage.size()), stage.data());
+				else
+					snprintf(nameBuffer, sizeof(nameBuffer), "  %.*s", static_cast<int>(detail.size()), detail.data());
+
+				const f64 busyMilliseconds = toMilliseconds(summary.BusyTicks);
+				const f64 wallMilliseconds = toMilliseconds(summary.LastEndTicks - summary.FirstStartTicks);
+				fprintf(stderr, "%-24s %10zu %12.2f %12.2f %12.2f %12.2f %12.2f\n", nameBuffer, summary.EventCount, static_cast<f64>(summary.ByteCount) / (1024.0 * 1024.0),
+					busyMilliseconds, wallMilliseconds, toMegabytesPerSecond(summary.ByteCount, busyMilliseconds), toMegabytesPerSecond(summary.ByteCount, wallMilliseconds));
+			}
+		}
+	}
+
+	namespace Hash
+	{
+		namespace
+		{
+			constexpr u64 XXH64Prime1 = 0x9E3779B185EBCA87ull;
+			constexpr u64 XXH64Prime2 = 0xC2B2AE3D27D4EB4Full;
+			constexpr u64 XXH64Prime3 = 0x165667B19E3779F9ull;
+			constexpr u64 XXH64Prime4 = 0x85EBCA77C2B2AE63ull;
+			constexpr u64 XXH64Prime5 = 0x27D4EB2F165667C5ull;
+
+			constexpr u64 RotateLeft64(u64 value, int shift) { return (value << shift) | (value >> (64 - shift)); }
+
+			inline u64 ReadU64(const u8* data) { u64 value; ::memcpy(&value, data, sizeof(value)); return value; }
+			inline u32 ReadU32(const u8* data) { u32 value; ::memcpy(&value, data, sizeof(value)); return value; }
+
+			constexpr u64 XXH64Round(u64 accumulator, u64 input)
+			{
+				accumulator += input * XXH64Prime2;
+				accumulator = RotateLeft64(accumulator, 31);
+				return accumulator * XXH64Prime1;
+			}
+
+			constexpr u64 XXH64MergeRound(u64 accumulator, u64 value)
+			{
+				accumulator ^= XXH64Round(0, value);
+				return accumulator * XXH64Prime1 + XXH64Prime4;
+			}
+
+			constexpr u64 XXH64Avalanche(u64 hash)
+			{
+				hash ^= hash >> 33;
+				hash *= XXH64Prime2;
+				hash ^= hash >> 29;
+				hash *= XXH64Prime3;
+				hash ^= hash >> 32;
+				return hash;
+			}
+
+			constexpr u32 XXH32Prime1 = 0x9E3779B1u;
+			constexpr u32 XXH32Prime2 = 0x85EBCA77u;
+			constexpr u32 XXH32Prime3 = 0xC2B2AE3Du;
+			constexpr u64 XXH3PrimeMx1 = 0x165667919E3779F9ull;
+			constexpr u64 XXH3PrimeMx2 = 0x9FB21C651E98DF25ull;
+
+			constexpr size_t XXH3StripeSize = 64;
+			constexpr size_t XXH3SecretConsumeRate = 8;
+			constexpr size_t XXH3SecretSizeMin = 136;
+			constexpr size_t XXH3MidSizeMax = 240;
+
+			alignas(64) constexpr u8 XXH3DefaultSecret[192] =
+			{
+				0xB8, 0xFE, 0x6C, 0x39, 0x23, 0xA4, 0x4B, 0xBE, 0x7C, 0x01, 0x81, 0x2C, 0xF7, 0x21, 0xAD, 0x1C,
+				0xDE, 0xD4, 0x6D, 0xE9, 0x83, 0x90, 0x97, 0xDB, 0x72, 0x40, 0xA4, 0xA4, 0xB7, 0xB3, 0x67, 0x1F,
+				0xCB, 0x79, 0xE6, 0x4E, 0xCC, 0xC0, 0xE5, 0x78, 0x82, 0x5A, 0xD0, 0x7D, 0xCC, 0xFF, 0x72, 0x21,
+				0xB8, 0x08, 0x46, 0x74, 0xF7, 0x43, 0x24, 0x8E, 0xE0, 0x35, 0x90, 0xE6, 0x81, 0x3A, 0x26, 0x4C,
+				0x3C, 0x28, 0x52, 0xBB, 0x91, 0xC3, 0x00, 0xCB, 0x88, 0xD0, 0x65, 0x8B, 0x1B, 0x53, 0x2E, 0xA3,
+				0x71, 0x64, 0x48, 0x97, 0xA2, 0x0D, 0xF9, 0x4E, 0x38, 0x19, 0xEF, 0x46, 0xA9, 0xDE, 0xAC, 0xD8,
+				0xA8, 0xFA, 0x76, 0x3F, 0xE3, 0x9C, 0x34, 0x3F, 0xF9, 0xDC, 0xBB, 0xC7, 0xC7, 0x0B, 0x4F, 0x1D,
+				0x8A, 0x51, 0xE0, 0x4B, 0xCD, 0xB4, 0x59, 0x31, 0xC8, 0x9F, 0x7E, 0xC9, 0xD9, 0x78, 0x73, 0x64,
+				0xEA, 0xC5, 0xAC, 0x83, 0x34, 0xD3, 0xEB, 0xC3, 0xC5, 0x81, 0xA0, 0xFF, 0xFA, 0x13, 0x63, 0xEB,
+				0x17, 0x0D, 0xDD, 0x51, 0xB7, 0xF0, 0xDA, 0x49, 0xD3, 0x16, 0x55, 0x26, 0x29, 0xD4, 0x68, 0x9E,
+				0x2B, 0x16, 0xBE, 0x58, 0x7D, 0x47, 0xA1, 0xFC, 0x8F, 0xF8, 0xB8, 0xD1, 0x7A, 0xD0, 0x31, 0xCE,
+				0x45, 0xCB, 0x3A, 0x8F, 0x95, 0x16, 0x04, 0x28, 0xAF, 0xD7, 0xFB, 0xCA, 0xBB, 0x4B, 0x40, 0x7E,
+			};
+
+			inline u64 ByteSwapU64(u64 value) { return _byteswap_uint64(value); }
+
+			inline u64 Multiply128Fold64(u64 a, u64 b)
+			{
+				u64 productHigh;
+				const u64 productLow = _umul128(a, b, &productHigh);
+				return (productLow ^ productHigh);
+			}
+
+			constexpr u64 XXH3Avalanche(u64 hash)
+			{
+				hash ^= hash >> 37;
+				hash *= XXH3PrimeMx1;
+				hash ^= hash >> 32;
+				return hash;
+			}
+
+			constexpr u64 XXH3RotateMultiplyXorShift(u64 hash, u64 length)
+			{
+				hash ^= RotateLeft64(hash, 49) ^ RotateLeft64(hash, 24);
+				hash *= XXH3PrimeMx2;
+				hash ^= (hash >> 35) + length;
+				hash *= XXH3PrimeMx2;
+				return hash ^ (hash >> 28);
+			}
+
+			inline u64 XXH3Mix16Bytes(const u8* data, const u8* secret)
+			{
+				return Multiply128Fold64(ReadU64(data) ^ ReadU64(secret), ReadU64(data + 8) ^ ReadU64(secret + 8));
+			}
+
+			bool CpuSupportsAvx2()
+			{
+				static const bool supported = []
+				{
+					int cpuInfo[4] = {};
+					::__cpuid(cpuInfo, 1);
+					constexpr int ecxOsXSaveBit = (1 << 27), ecxAvxBit = (1 << 28);
+					if ((cpuInfo[2] & ecxOsXSaveBit) == 0 || (cpuInfo[2] & ecxAvxBit) == 0)
+						return false;
+
+					// NOTE: The OS also has to save and restore the YMM registers on context switches
+					constexpr u64 xcr0SseAndAvxStateBits = 0x6;
+					if ((::_xgetbv(0) & xcr0SseAndAvxStateBits) != xcr0SseAndAvxStateBits)
+						return false;
+
+					::__cpuidex(cpuInfo, 7, 0);
+					constexpr int ebxAvx2Bit = (1 << 5);
+					return ((cpuInfo[1] & ebxAvx2Bit) != 0);
+				}();
+				return supported;
+			}
+
+			struct XXH3Sse2Kernel
+			{
+				static void Accumulate512(u64* accumulators, const u8* input, const u8* secret)
+				{
+					__m128i* const accumulatorVectors = reinterpret_cast<__m128i*>(accumulators);
+					for (size_t i = 0; i < (XXH3StripeSize / sizeof(__m128i)); i++)
+					{
+						const __m128i dataVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+						const __m128i keyVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+						const __m128i dataKey = _mm_xor_si128(dataVector, keyVector);
+						const __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+						const __m128i sum = _mm_add_epi64(accumulatorVectors[i], _mm_shuffle_epi32(dataVector, _MM_SHUFFLE(1, 0, 3, 2)));
+						accumulatorVectors[i] = _mm_add_epi64(product, sum);
+					}
+				}
+
+				static void Scramble(u64* accumulators, const u8* secret)
+				{
+					__m128i* const accumulatorVectors = reinterpret_cast<__m128i*>(accumulators);
+					const __m128i prime32 = _mm_set1_epi32(static_cast<int>(XXH32Prime1));
+					for (size_t i = 0; i < (XXH3StripeSize / sizeof(__m128i)); i++)
+					{
+						const __m128i accumulatorVector = accumulatorVectors[i];
+						const __m128i dataVector = _mm_xor_si128(accumulatorVector, _mm_srli_epi64(accumulatorVector, 47));
+						const __m128i dataKey = _mm_xor_si128(dataVector, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+						const __m128i productLow = _mm_mul_epu32(dataKey, prime32);
+						const __m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)), prime32);
+						accumulatorVectors[i] = _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+					}
+				}
+			};
+
+			struct XXH3Avx2Kernel
+			{
+				static void Accumulate512(u64* accumulators, const u8* input, const u8* secret)
+				{
+					__m256i* const accumulatorVectors = reinterpret_cast<__m256i*>(accumulators);
+					for (size_t i = 0; i < (XXH3StripeSize / sizeof(__m256i)); i++)
+					{
+						const __m256i dataVector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + i);
+						const __m256i keyVector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i);
+						const __m256i dataKey = _mm256_xor_si256(dataVector, keyVector);
+						const __m256i product = _mm256_mul_epu32(dataKey, _mm256_srli_epi64(dataKey, 32));
+						const __m256i sum = _mm256_add_epi64(accumulatorVectors[i], _mm256_shuffle_epi32(dataVector, _MM_SHUFFLE(1, 0, 3, 2)));
+						accumulatorVectors[i] = _mm256_add_epi64(product, sum);
+					}
+				}
+
+				static void Scramble(u64* accumulators, const u8* secret)
+				{
+					__m256i* const accumulatorVectors = reinterpret_cast<__m256i*>(accumulators);
+					const __m256i prime32 = _mm256_set1_epi32(static_cast<int>(XXH32Prime1));
+					for (size_t i = 0; i < (XXH3StripeSize / sizeof(__m256i)); i++)
+					{
+						const __m256i accumulatorVector = accumulatorVectors[i];
+						const __m256i dataVector = _mm256_xor_si256(accumulatorVector, _mm256_srli_epi64(accumulatorVector, 47));
+						const __m256i dataKey = _mm256_xor_si256(dataVector, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i));
+						const __m256i productLow = _mm256_mul_epu32(dataKey, prime32);
+						const __m256i productHigh = _mm256_mul_epu32(_mm256_srli_epi64(dataKey, 32), prime32);
+						accumulatorVectors[i] = _mm256_add_epi64(productLow, _mm256_slli_epi64(productHigh, 32));
+					}
+				}
+			};
+
+			constexpr size_t XXH3AccumulatorCount = 8;
+			constexpr size_t XXH3MergeSecretOffset = 11;
+
+			template <typename Kernel>
+			void XXH3AccumulateLong(u64(&accumulators)[XXH3AccumulatorCount], const u8* data, size_t dataSize)
+			{
+				const u8* const secret = XXH3DefaultSecret;
+				constexpr size_t secretSize = sizeof(XXH3DefaultSecret);
+				constexpr size_t stripesPerBlock = (secretSize - XXH3StripeSize) / XXH3SecretConsumeRate;
+				constexpr size_t blockSize = (XXH3StripeSize * stripesPerBlock);
+
+				const size_t blockCount = (dataSize - 1) / blockSize;
+				for (size_t block = 0; block < blockCount; block++)
+				{
+					for (size_t stripe = 0; stripe < stripesPerBlock; stripe++)
+						Kernel::Accumulate512(accumulators, data + (block * blockSize) + (stripe * XXH3StripeSize), secret + (stripe * XXH3SecretConsumeRate));
+					Kernel::Scramble(accumulators, secret + secretSize - XXH3StripeSize);
+				}
+
+				const size_t lastBlockStripeCount = ((dataSize - 1) - (blockSize * blockCount)) / XXH3StripeSize;
+				for (size_t stripe = 0; stripe < lastBlockStripeCount; stripe++)
+					Kernel::Accumulate512(accumulators, data + (blockCount * blockSize) + (stripe * XXH3StripeSize), secret + (stripe * XXH3SecretConsumeRate));
+
+				constexpr size_t lastStripeSecretOffset = 7;
+				Kernel::Accumulate512(accumulators, data + dataSize - XXH3StripeSize, secret + secretSize - XXH3StripeSize - lastStripeSecretOffset);
+			}
+
+			void XXH3AccumulateLong(u64(&accumulators)[XXH3AccumulatorCount], const u8* data, size_t dataSize)
+			{
+				if (CpuSupportsAvx2())
+					XXH3AccumulateLong<XXH3Avx2Kernel>(accumulators, data, dataSize);
+				else
+					XXH3AccumulateLong<XXH3Sse2Kernel>(accumulators, data, dataSize);
+			}
+
+			u64 XXH3MergeAccumulators(const u64(&accumulators)[XXH3AccumulatorCount], const u8* secret, u64 start)
+			{
+				u64 result = start;
+				for (size_t i = 0; i < (XXH3AccumulatorCount / 2); i++)
+					result += Multiply128Fold64(accumulators[(2 * i) + 0] ^ ReadU64(secret + (16 * i)), accumulators[(2 * i) + 1] ^ ReadU64(secret + (16 * i) + 8));
+
+				return XXH3Avalanche(result);
+			}
+
+			// NOTE: Shared by both halves of the 128-bit variant for inputs of 17 to 240 bytes
+			inline void XXH128Mix32Bytes(u64& accumulatorLow, u64& accumulatorHigh, const u8* dataA, const u8* dataB, const u8* secret)
+			{
+				accumulatorLow += XXH3Mix16Bytes(dataA, secret);
+				accumulatorLow ^= ReadU64(dataB) + ReadU64(dataB + 8);
+				accumulatorHigh += XXH3Mix16Bytes(dataB, secret + 16);
+				accumulatorHigh ^= ReadU64(dataA) + ReadU64(dataA + 8);
+			}
+		}
+
+		u64 ComputeXXH64(const u8* data, size_t dataSize, u64 seed)
+		{
+			const u8* readHead = data;
+			const u8* const dataEnd = (data + dataSize);
+			u64 hash;
+
+			if (dataSize >= 32)
+			{
+				u64 v1 = seed + XXH64Prime1 + XXH64Prime2;
+				u64 v2 = seed + XXH64Prime2;
+				u64 v3 = seed;
+				u64 v4 = seed - XXH64Prime1;
+
+				for (const u8* const stripeLimit = (dataEnd - 32); readHead <= stripeLimit; readHead += 32)
+				{
+					v1 = XXH64Round(v1, ReadU64(readHead + 0));
+					v2 = XXH64Round(v2, ReadU64(readHead + 8));
+					v3 = XXH64Round(v3, ReadU64(readHead + 16));
+					v4 = XXH64Round(v4, ReadU64(readHead + 24));
+				}
+
+				hash = RotateLeft64(v1, 1) + RotateLeft64(v2, 7) + RotateLeft64(v3, 12) + RotateLeft64(v4, 18);
+				hash = XXH64MergeRound(hash, v1);
+				hash = XXH64MergeRound(hash, v2);
+				hash = XXH64MergeRound(hash, v3);
+				hash = XXH64MergeRound(hash, v4);
+			}
+			else
+			{
+				hash = seed + XXH64Prime5;
+			}
+
+			hash += static_cast<u64>(dataSize);
+
+			for (; (dataEnd - readHead) >= 8; readHead += 8)
+				hash = RotateLeft64(hash ^ XXH64Round(0, ReadU64(readHead)), 27) * XXH64Prime1 + XXH64Prime4;
+
+			if ((dataEnd - readHead) >= 4)
+			{
+				hash = RotateLeft64(hash ^ (static_cast<u64>(ReadU32(readHead)) * XXH64Prime1), 23) * XXH64Prime2 + XXH64Prime3;
+				readHead += 4;
+			}
+
+			for (; readHead < dataEnd; readHead++)
+				hash = RotateLeft64(hash ^ (static_cast<u64>(*readHead) * XXH64Prime5), 11) * XXH64Prime1;
+
+			return XXH64Avalanche(hash);
+		}
+
+		u64 ComputeXXH3(const u8* data, size_t dataSize)
+		{
+			const u8* const secret = XXH3DefaultSecret;
+
+			if (dataSize <= 16)
+			{
+				if (dataSize > 8)
+				{
+					const u64 inputLow = ReadU64(data) ^ (ReadU64(secret + 24) ^ ReadU64(secret + 32));
+					const u64 inputHigh = ReadU64(data + dataSize - 8) ^ (ReadU64(secret + 40) ^ ReadU64(secret + 48));
+					return XXH3Avalanche(static_cast<u64>(dataSize) + ByteSwapU64(inputLow) + inputHigh + Multiply128Fold64(inputLow, inputHigh));
+				}
+
+				if (dataSize >= 4)
+				{
+					const u64 input64 = static_cast<u64>(ReadU32(data + dataSize - 4)) + (static_cast<u64>(ReadU32(data)) << 32);
+					return XXH3RotateMultiplyXorShift(input64 ^ (ReadU64(secret + 8) ^ ReadU64(secret + 16)), dataSize);
+				}
+
+				if (dataSize > 0)
+				{
+					const u32 combined = (static_cast<u32>(data[0]) << 16) | (static_cast<u32>(data[dataSize >> 1]) << 24) | static_cast<u32>(data[dataSize - 1]) | (static_cast<u32>(dataSize) << 8);
+					return XXH64Avalanche(static_cast<u64>(combined) ^ static_cast<u64>(ReadU32(secret) ^ ReadU32(secret + 4)));
+				}
+
+				return XXH64Avalanche(ReadU64(secret + 56) ^ ReadU64(secret + 64));
+			}
+
+			if (dataSize <= 128)
+			{
+				u64 accumulator = static_cast<u64>(dataSize) * XXH64Prime1;
+				for (size_t i = 0; i < 4 && (i == 0 || dataSize > (i * 32)); i++)
+				{
+					accumulator += XXH3Mix16Bytes(data + (16 * i), secret + (32 * i));
+					accumulator += XXH3Mix16Bytes(data + dataSize - (16 * (i + 1)), secret + (32 * i) + 16);
+				}
+				return XXH3Avalanche(accumulator);
+			}
+
+			if (dataSize <= XXH3MidSizeMax)
+			{
+				u64 accumulator = static_cast<u64>(dataSize) * XXH64Prime1;
+				for (size_t i = 0; i < 8; i++)
+					accumulator += XXH3Mix16Bytes(data + (16 * i), secret + (16 * i));
+
+				accumulator = XXH3Avalanche(accumulator);
+
+				u64 endAccumulator = XXH3Mix16Bytes(data + dataSize - 16, secret + XXH3SecretSizeMin - 17);
+				for (size_t i = 8; i < (dataSize / 16); i++)
+					endAccumulator += XXH3Mix16Bytes(data + (16 * i), secret + (16 * (i - 8)) + 3);
+
+				return XXH3Avalanche(accumulator + endAccumulator);
+			}
+
+			alignas(32) u64 accumulators[XXH3AccumulatorCount] = { XXH32Prime3, XXH64Prime1, XXH64Prime2, XXH64Prime3, XXH64Prime4, XXH32Prime2, XXH64Prime5, XXH32Prime1 };
+			XXH3AccumulateLong(accumulators, data, dataSize);
+
+			return XXH3MergeAccumulators(accumulators, secret + XXH3MergeSecretOffset, static_cast<u64>(dataSize) * XXH64Prime1);
+		}
+
+		Hash128 ComputeXXH128(const u8* data, size_t dataSize)
+		{
+			const u8* const secret = XXH3DefaultSecret;
+			Hash128 hash;
+
+			if (dataSize <= 16)
+			{
+				if (dataSize > 8)
+				{
+					const u64 bitFlipLow = (ReadU64(secret + 32) ^ ReadU64(secret + 40));
+					const u64 bitFlipHigh = (ReadU64(secret + 48) ^ ReadU64(secret + 56));
+					const u64 inputLow = ReadU64(data);
+					const u64 inputHigh = ReadU64(data + dataSize - 8) ^ bitFlipHigh;
+
+					u64 productHigh;
+					u64 productLow = _umul128(inputLow ^ inputHigh ^ bitFlipLow ^ bitFlipHigh, XXH64Prime1, &productHigh);
+					productLow += static_cast<u64>(dataSize - 1) << 54;
+					productHigh += inputHigh + (static_cast<u64>(static_cast<u32>(inputHigh)) * (XXH32Prime2 - 1));
+					productLow ^= ByteSwapU64(productHigh);
+
+					hash.Low = _umul128(productLow, XXH64Prime2, &hash.High);
+					hash.High += productHigh * XXH64Prime2;
+					hash.Low = XXH3Avalanche(hash.Low);
+					hash.High = XXH3Avalanche(hash.High);
+					return hash;
+				}
+
+				if (dataSize >= 4)
+				{
+					const u64 input64 = static_cast<u64>(ReadU32(data)) + (static_cast<u64>(ReadU32(data + dataSize - 4)) << 32);
+					const u64 keyed = input64 ^ (ReadU64(secret + 16) ^ ReadU64(secret + 24));
+
+					hash.Low = _umul128(keyed, XXH64Prime1 + (static_cast<u64>(dataSize) << 2), &hash.High);
+					hash.High += (hash.Low << 1);
+					hash.Low ^= (hash.High >> 3);
+					hash.Low ^= (hash.Low >> 35);
+					hash.Low *= XXH3PrimeMx2;
+					hash.Low ^= (hash.Low >> 28);
+					hash.High = XXH3Avalanche(hash.High);
+					return hash;
+				}
+
+				if (dataSize > 0)
+				{
+					const u32 combinedLow = (static_cast<u32>(data[0]) << 16) | (static_cast<u32>(data[dataSize >> 1]) << 24) | static_cast<u32>(data[dataSize - 1]) | (static_cast<u32>(dataSize) << 8);
+					const u32 combinedHigh = _rotl(_byteswap_ulong(combinedLow), 13);
+					hash.Low = XXH64Avalanche(static_cast<u64>(combinedLow) ^ static_cast<u64>(ReadU32(secret) ^ ReadU32(secret + 4)));
+					hash.High = XXH64Avalanche(static_cast<u64>(combinedHigh) ^ static_cast<u64>(ReadU32(secret + 8) ^ ReadU32(secret + 12)));
+					return hash;
+				}
+
+				hash.Low = XXH64Avalanche(ReadU64(secret + 64) ^ ReadU64(secret + 72));
+				hash.High = XXH64Avalanche(ReadU64(secret + 80) ^ ReadU64(secret + 88));
+				return hash;
+			}
+
+			if (dataSize <= XXH3MidSizeMax)
+			{
+				u64 accumulatorLow = static_cast<u64>(dataSize) * XXH64Prime1;
+				u64 accumulatorHigh = 0;
+
+				if (dataSize <= 128)
+				{
+					for (size_t i = 4; i-- > 0;)
+					{
+						if (i == 0 || dataSize > (i * 32))
+							XXH128Mix32Bytes(accumulatorLow, accumulatorHigh, data + (16 * i), data + dataSize - (16 * (i + 1)), secret + (32 * i));
+					}
+				}
+				else
+				{
+					for (size_t i = 32; i < 160; i += 32)
+						XXH128Mix32Bytes(accumulatorLow, accumulatorHigh, data + i - 32, data + i - 16, secret + i - 32);
+
+					accumulatorLow = XXH3Avalanche(accumulatorLow);
+					accumulatorHigh = XXH3Avalanche(accumulatorHigh);
+
+					constexpr size_t midSizeStartOffset = 3, midSizeLastOffset = 17;
+					for (size_t i = 160; i <= dataSize; i += 32)
+						XXH128Mix32Bytes(accumulatorLow, accumulatorHigh, data + i - 32, data + i - 16, secret + midSizeStartOffset + i - 160);
+					XXH128Mix32Bytes(accumulatorLow, accumulatorHigh, data + dataSize - 16, data + dataSize - 32, secret + XXH3SecretSizeMin - midSizeLastOffset - 16);
+				}
+
+				hash.Low = XXH3Avalanche(accumulatorLow + accumulatorHigh);
+				hash.High = 0 - XXH3Avalanche((accumulatorLow * XXH64Prime1) + (accumulatorHigh * XXH64Prime4) + (static_cast<u64>(dataSize) * XXH64Prime2));
+				return hash;
+			}
+
+			alignas(32) u64 accumulators[XXH3AccumulatorCount] = { XXH32Prime3, XXH64Prime1, XXH64Prime2, XXH64Prime3, XXH64Prime4, XXH32Prime2, XXH64Prime5, XXH32Prime1 };
+			XXH3AccumulateLong(accumulators, data, dataSize);
+
+			hash.Low = XXH3MergeAccumulators(accumulators, secret + XXH3MergeSecretOffset, static_cast<u64>(dataSize) * XXH64Prime1);
+			hash.High = XXH3MergeAccumulators(accumulators, secret + sizeof(XXH3DefaultSecret) - sizeof(accumulators) - XXH3MergeSecretOffset, ~(static_cast<u64>(dataSize) * XXH64Prime2));
+			return hash;
+		}
+	}
+
+	namespace Crypto
+	{
+		namespace Detail
+		{
+			constexpr size_t Aes128RoundCount = 10;
+			constexpr size_t Aes128BlockSize = 16;
+			constexpr size_t Aes128ParallelBlocks = 8;
+
+			using Aes128RoundKeys = std::array<std::array<u8, Aes128BlockSize>, Aes128RoundCount + 1>;
+
+			constexpr u8 SBox[256] =
+			{
+				0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+				0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+				0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+				0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+				0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+				0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+				0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+				0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+				0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+				0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+				0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+				0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+				0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+				0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+				0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+				0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16,
+			};
+
+			constexpr u8 InverseSBox[256] =
+			{
+				0x52, 0x09, 0x6A, 0xD5, 0x30, 0x36, 0xA5, 0x38, 0xBF, 0x40, 0xA3, 0x9E, 0x81, 0xF3, 0xD7, 0xFB,
+				0x7C, 0xE3, 0x39, 0x82, 0x9B, 0x2F, 0xFF, 0x87, 0x34, 0x8E, 0x43, 0x44, 0xC4, 0xDE, 0xE9, 0xCB,
+				0x54, 0x7B, 0x94, 0x32, 0xA6, 0xC2, 0x23, 0x3D, 0xEE, 0x4C, 0x95, 0x0B, 0x42, 0xFA, 0xC3, 0x4E,
+				0x08, 0x2E, 0xA1, 0x66, 0x28, 0xD9, 0x24, 0xB2, 0x76, 0x5B, 0xA2, 0x49, 0x6D, 0x8B, 0xD1, 0x25,
+				0x72, 0xF8, 0xF6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xD4, 0xA4, 0x5C, 0xCC, 0x5D, 0x65, 0xB6, 0x92,
+				0x6C, 0x70, 0x48, 0x50, 0xFD, 0xED, 0xB9, 0xDA, 0x5E, 0x15, 0x46, 0x57, 0xA7, 0x8D, 0x9D, 0x84,
+				0x90, 0xD8, 0xAB, 0x00, 0x8C, 0xBC, 0xD3, 0x0A, 0xF7, 0xE4, 0x58, 0x05, 0xB8, 0xB3, 0x45, 0x06,
+				0xD0, 0x2C, 0x1E, 0x8F, 0xCA, 0x3F, 0x0F, 0x02, 0xC1, 0xAF, 0xBD, 0x03, 0x01, 0x13, 0x8A, 0x6B,
+				0x3A, 0x91, 0x11, 0x41, 0x4F, 0x67, 0xDC, 0xEA, 0x97, 0xF2, 0xCF, 0xCE, 0xF0, 0xB4, 0xE6, 0x73,
+				0x96, 0xAC, 0x74, 0x22, 0xE7, 0xAD, 0x35, 0x85, 0xE2, 0xF9, 0x37, 0xE8, 0x1C, 0x75, 0xDF, 0x6E,
+				0x47, 0xF1, 0x1A, 0x71, 0x1D, 0x29, 0xC5, 0x89, 0x6F, 0xB7, 0x62, 0x0E, 0xAA, 0x18, 0xBE, 0x1B,
+				0xFC, 0x56, 0x3E, 0x4B, 0xC6, 0xD2, 0x79, 0x20, 0x9A, 0xDB, 0xC0, 0xFE, 0x78, 0xCD, 0x5A, 0xF4,
+				0x1F, 0xDD, 0xA8, 0x33, 0x88, 0x07, 0xC7, 0x31, 0xB1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xEC, 0x5F,
+				0x60, 0x51, 0x7F, 0xA9, 0x19, 0xB5, 0x4A, 0x0D, 0x2D, 0xE5, 0x7A, 0x9F, 0x93, 0xC9, 0x9C, 0xEF,
+				0xA0, 0xE0, 0x3B, 0x4D, 0xAE, 0x2A, 0xF5, 0xB0, 0xC8, 0xEB, 0xBB, 0x3C, 0x83, 0x53, 0x99, 0x61,
+				0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26, 0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D,
+			};
+
+			constexpr u8 RoundConstants[Aes128RoundCount] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36 };
+
+			constexpr u8 GaloisMultiplyBy2(u8 value) { return static_cast<u8>((value << 1) ^ ((value & 0x80) ? 0x1B : 0x00)); }
+			constexpr u8 GaloisMultiply(u8 value, u8 factor)
+			{
+				u8 result = 0;
+				for (; factor != 0; factor >>= 1, value = GaloisMultiplyBy2(value))
+					result ^= (factor & 1) ? value : 0;
+				return result;
+			}
+
+			bool CpuSupportsAesNi()
+			{
+				static const bool supported = []
+				{
+					int cpuInfo[4] = {};
+					::__cpuid(cpuInfo, 1);
+					constexpr int ecxAesNiBit = (1 << 25), ecxSse41Bit = (1 << 19);
+					return ((cpuInfo[2] & ecxAesNiBit) != 0) && ((cpuInfo[2] & ecxSse41Bit) != 0);
+				}();
+				return supported;
+			}
+
+			Aes128RoundKeys ExpandAes128Key(const Aes128KeyBytes& key)
+			{
+				Aes128RoundKeys roundKeys = {};
+				::memcpy(roundKeys[0].data(), key.data(), Aes128KeySize);
+
+				for (size_t round = 1; round <= Aes128RoundCount; round++)
+				{
+					const auto& previous = roundKeys[round - 1];
+					auto& current = roundKeys[round];
+
+					const u8 rotatedSubstitutedWord[4] = { SBox[previous[13]], SBox[previous[14]], SBox[previous[15]], SBox[previous[12]] };
+					for (size_t i = 0; i < 4; i++)
+						current[i] = previous[i] ^ rotatedSubstitutedWord[i] ^ ((i == 0) ? RoundConstants[round - 1] : 0x00);
+					for (size_t i = 4; i < Aes128BlockSize; i++)
+						current[i] = previous[i] ^ current[i - 4];
+				}
+
+				return roundKeys;
+			}
+
+			// NOTE: Plain byte oriented reference implementation used when the CPU lacks the AES instructions
+			namespace Scalar
+			{
+				void AddRoundKey(u8* state, const u8* roundKey) { for (size_t i = 0; i < Aes128BlockSize; i++) state[i] ^= roundKey[i]; }
+
+				void SubBytes(u8* state) { for (size_t i = 0; i < Aes128BlockSize; i++) state[i] = SBox[state[i]]; }
+				void InverseSubBytes(u8* state) { for (size_t i = 0; i < Aes128BlockSize; i++) state[i] = InverseSBox[state[i]]; }
+
+				void ShiftRows(u8* state)
+				{
+					const u8 copy[Aes128BlockSize] = { state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7], state[8], state[9], state[10], state[11], state[12], state[13], state[14], state[15] };
+					for (size_t column = 0; column < 4; column++)
+						for (size_t row = 0; row < 4; row++)
+							state[(column * 4) + row] = copy[(((column + row) % 4) * 4) + row];
+				}
+
+				void InverseShiftRows(u8* state)
+				{
+					const u8 copy[Aes128BlockSize] = { state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7], state[8], state[9], state[10], state[11], state[12], state[13], state[14], state[15] };
+					for (size_t column = 0; column < 4; column++)
+						for (size_t row = 0; row < 4; row++)
+							state[(((column + row) % 4) * 4) + row] = copy[(column * 4) + row];
+				}
+
+				void MixColumns(u8* state)
+				{
+					for (size_t column = 0; column < 4; column++)
+					{
+						u8* c = &state[column * 4];
+						const u8 a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+						c[0] = GaloisMultiply(a0, 2) ^ GaloisMultiply(a1, 3) ^ a2 ^ a3;
+						c[1] = a0 ^ GaloisMultiply(a1, 2) ^ GaloisMultiply(a2, 3) ^ a3;
+						c[2] = a0 ^ a1 ^ GaloisMultiply(a2, 2) ^ GaloisMultiply(a3, 3);
+						c[3] = GaloisMultiply(a0, 3) ^ a1 ^ a2 ^ GaloisMultiply(a3, 2);
+					}
+				}
+
+				void InverseMixColumns(u8* state)
+				{
+					for (size_t column = 0; column < 4; column++)
+					{
+						u8* c = &state[column * 4];
+						const u8 a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+						c[0] = GaloisMultiply(a0, 14) ^ GaloisMultiply(a1, 11) ^ GaloisMultiply(a2, 13) ^ GaloisMultiply(a3, 9);
+						c[1] = GaloisMultiply(a0, 9) ^ GaloisMultiply(a1, 14) ^ GaloisMultiply(a2, 11) ^ GaloisMultiply(a3, 13);
+						c[2] = GaloisMultiply(a0, 13) ^ GaloisMultiply(a1, 9) ^ GaloisMultiply(a2, 14) ^ GaloisMultiply(a3, 11);
+						c[3] = GaloisMultiply(a0, 11) ^ GaloisMultiply(a1, 13) ^ GaloisMultiply(a2, 9) ^ GaloisMultiply(a3, 14);
+					}
+				}
+
+				void EncryptBlock(u8* state, const Aes128RoundKeys& roundKeys)
+				{
+					AddRoundKey(state, roundKeys[0].data());
+					for (size_t round = 1; round < Aes128RoundCount; round++)
+					{
+						SubBytes(state);
+						ShiftRows(state);
+						MixColumns(state);
+						AddRoundKey(state, roundKeys[round].data());
+					}
+					SubBytes(state);
+					ShiftRows(state);
+					AddRoundKey(state, roundKeys[Aes128RoundCount].data());
+				}
+
+				void DecryptBlock(u8* state, const Aes128RoundKeys& roundKeys)
+				{
+					AddRoundKey(state, roundKeys[Aes128RoundCount].data());
+					for (size_t round = Aes128RoundCount - 1; round > 0; round--)
+					{
+						InverseShiftRows(state);
+						InverseSubBytes(state);
+						AddRoundKey(state, roundKeys[round].data());
+						InverseMixColumns(state);
+					}
+					InverseShiftRows(state);
+					InverseSubBytes(state);
+					AddRoundKey(state, roundKeys[0].data());
+				}
+
+				void DecryptCbc(const u8* inData, u8* outData, size_t blockCount, const Aes128RoundKeys& roundKeys, const u8* iv)
+				{
+					u8 previousCipherBlock[Aes128BlockSize], currentCipherBlock[Aes128BlockSize], block[Aes128BlockSize];
+					::memcpy(previousCipherBlock, iv, Aes128BlockSize);
+
+					for (size_t blockIndex = 0; blockIndex < blockCount; blockIndex++)
+					{
+						::memcpy(currentCipherBlock, &inData[blockIndex * Aes128BlockSize], Aes128BlockSize);
+						::memcpy(block, currentCipherBlock, Aes128BlockSize);
+
+						DecryptBlock(block, roundKeys);
+						for (size_t i = 0; i < Aes128BlockSize; i++)
+							outData[(blockIndex * Aes128BlockSize) + i] = block[i] ^ previousCipherBlock[i];
+
+						::memcpy(previousCipherBlock, currentCipherBlock, Aes128BlockSize);
+					}
+				}
+
+				void EncryptCbc(const u8* inData, u8* outData, size_t blockCount, const Aes128RoundKeys& roundKeys, const u8* iv)
+				{
+					u8 block[Aes128BlockSize];
+					::memcpy(block, iv, Aes128BlockSize);
+
+					for (size_t blockIndex = 0; blockIndex < blockCount; blockIndex++)
+					{
+						for (size_t i = 0; i < Aes128BlockSize; i++)
+							block[i] ^= inData[(blockIndex * Aes128BlockSize) + i];
+
+						EncryptBlock(block, roundKeys);
+						::memcpy(&outData[blockIndex * Aes128BlockSize], block, Aes128BlockSize);
+					}
+				}
+			}
+
+			// NOTE: Every CBC plaintext block only depends on its own and the previous ciphertext block,
+			//		 so decryption keeps multiple independent blocks in flight to hide the AESDEC latency.
+			//		 All ciphertext blocks of a batch are loaded before any are stored so in-place operation stays safe
+			namespace AesNi
+			{
+				void DecryptCbc(const u8* inData, u8* outData, size_t blockCount, const Aes128RoundKeys& roundKeys, const u8* iv)
+				{
+					__m128i decryptionKeys[Aes128RoundCount + 1];
+					decryptionKeys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys[Aes128RoundCount].data()));
+					for (size_t round = 1; round < Aes128RoundCount; round++)
+						decryptionKeys[round] = _mm_aesimc_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys[Aes128RoundCount - round].data())));
+					decryptionKeys[Aes128RoundCount] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys[0].data()));
+
+					const __m128i* inBlocks = reinterpret_cast<const __m128i*>(inData);
+					__m128i* outBlocks = reinterpret_cast<__m128i*>(outData);
+					__m128i previousCipherBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+
+					size_t blockIndex = 0;
+					for (; blockIndex + Aes128ParallelBlocks <= blockCount; blockIndex += Aes128ParallelBlocks)
+					{
+						__m128i cipherBlocks[Aes128ParallelBlocks], blocks[Aes128ParallelBlocks];
+						for (size_t i = 0; i < Aes128ParallelBlocks; i++)
+							blocks[i] = _mm_xor_si128(cipherBlocks[i] = _mm_loadu_si128(&inBlocks[blockIndex + i]), decryptionKeys[0]);
+
+						for (size_t round = 1; round < Aes128RoundCount; round++)
+						{
+							for (size_t i = 0; i < Aes128ParallelBlocks; i++)
+								blocks[i] = _mm_aesdec_si128(blocks[i], decryptionKeys[round]);
+						}
+
+						for (size_t i = 0; i < Aes128ParallelBlocks; i++)
+							blocks[i] = _mm_aesdeclast_si128(blocks[i], decryptionKeys[Aes128RoundCount]);
+
+						_mm_storeu_si128(&outBlocks[blockIndex + 0], _mm_xor_si128(blocks[0], previousCipherBlock));
+						for (size_t i = 1; i < Aes128ParallelBlocks; i++)
+							_mm_storeu_si128(&outBlocks[blockIndex + i], _mm_xor_si128(blocks[i], cipherBlocks[i - 1]));
+
+						previousCipherBlock = cipherBlocks[Aes128ParallelBlocks - 1];
+					}
+
+					for (; blockIndex < blockCount; blockIndex++)
+					{
+						const __m128i cipherBlock = _mm_loadu_si128(&inBlocks[blockIndex]);
+						__m128i block = _mm_xor_si128(cipherBlock, decryptionKeys[0]);
+
+						for (size_t round = 1; round < Aes128RoundCount; round++)
+							block = _mm_aesdec_si128(block, decryptionKeys[round]);
+						block = _mm_aesdeclast_si128(block, decryptionKeys[Aes128RoundCount]);
+
+						_mm_storeu_si128(&outBlocks[blockIndex], _mm_xor_si128(block, previousCipherBlock));
+						previousCipherBlock = cipherBlock;
+					}
+				}
+
+				void EncryptCbc(const u8* inData, u8* outData, size_t blockCount, const Aes128RoundKeys& roundKeys, const u8* iv)
+				{
+					__m128i encryptionKeys[Aes128RoundCount + 1];
+					for (size_t round = 0; round <= Aes128RoundCount; round++)
+						encryptionKeys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys[round].data()));
+
+					const __m128i* inBlocks = reinterpret_cast<const __m128i*>(inData);
+					__m128i* outBlocks = reinterpret_cast<__m128i*>(outData);
+					__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+
+					for (size_t blockIndex = 0; blockIndex < blockCount; blockIndex++)
+					{
+						block = _mm_xor_si128(_mm_xor_si128(block, _mm_loadu_si128(&inBlocks[blockIndex])), encryptionKeys[0]);
+						for (size_t round = 1; round < Aes128RoundCount; round++)
+							block = _mm_aesenc_si128(block, encryptionKeys[round]);
+						block = _mm_aesenclast_si128(block, encryptionKeys[Aes128RoundCount]);
+
+						_mm_storeu_si128(&outBlocks[blockIndex], block);
+					}
+				}
+			}
+		}
+
+		bool DecryptAes128Cbc(const u8* inEncryptedData, u8* outDecryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv)
+		{
+			if (Align(inOutDataSize, Aes128Alignment) != inOutDataSize)
+			{
+				fprintf(stderr, "DecryptAes128Cbc() data size 0x%zX is not a multiple of the AES block size\n", inOutDataSize);
+				return false;
+			}
+
+			const auto roundKeys = Detail::ExpandAes128Key(key);
+			const size_t blockCount = (inOutDataSize / Detail::Aes128BlockSize);
+
+			if (Detail::CpuSupportsAesNi())
+				Detail::AesNi::DecryptCbc(inEncryptedData, outDecryptedData, blockCount, roundKeys, iv.data());
+			else
+				Detail::Scalar::DecryptCbc(inEncryptedData, outDecryptedData, blockCount, roundKeys, iv.data());
+			return true;
+		}
+
+		bool DecryptAes128Cbc(const u8* inEncryptedData, u8* outDecryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv, Threading::ThreadPool& threadPool)
+		{
+			// NOTE: Small enough that every thread gets work on medium sized inputs but large enough to amortize the task overhead
+			constexpr size_t minSliceSize = (256 * 1024);
+
+			if (Align(inOutDataSize, Aes128Alignment) != inOutDataSize)
+			{
+				fprintf(stderr, "DecryptAes128Cbc() data size 0x%zX is not a multiple of the AES block size\n", inOutDataSize);
+				return false;
+			}
+
+			const size_t blockCount = (inOutDataSize / Detail::Aes128BlockSize);
+			const size_t sliceCount = std::min<size_t>(threadPool.GetThreadCount(), inOutDataSize / minSliceSize);
+			if (sliceCount <= 1)
+				return DecryptAes128Cbc(inEncryptedData, outDecryptedData, inOutDataSize, key, iv);
+
+			const size_t blocksPerSlice = (blockCount + (sliceCount - 1)) / sliceCount;
+
+			// NOTE: Each slice is chained to the last ciphertext block of the slice before it. These have to be copied out before any
+			//		 slice gets decrypted because with in-place decryption they would otherwise already have been overwritten by plaintext
+			std::vector<Aes128IVBytes> sliceIVs(sliceCount);
+			sliceIVs[0] = iv;
+			for (size_t sliceIndex = 1; sliceIndex < sliceCount; sliceIndex++)
+				::memcpy(sliceIVs[sliceIndex].data(), &inEncryptedData[((sliceIndex * blocksPerSlice) - 1) * Detail::Aes128BlockSize], Aes128IVSize);
+
+			// NOTE: Waits on its own task group only so it's safe to call from within a task of the same pool and unaffected by any unrelated tasks
+			Threading::TaskGroup sliceTaskGroup;
+			std::atomic<size_t> failedSliceCount = 0;
+
+			for (size_t sliceIndex = 0; sliceIndex < sliceCount; sliceIndex++)
+			{
+				const size_t firstBlock = (sliceIndex * blocksPerSlice);
+				const size_t sliceBlockCount = std::min(blocksPerSlice, blockCount - firstBlock);
+				const size_t sliceOffset = (firstBlock * Detail::Aes128BlockSize);
+
+				threadPool.Enqueue(sliceTaskGroup, [=, &sliceIVs, &failedSliceCount]
+				{
+					if (!DecryptAes128Cbc(inEncryptedData + sliceOffset, outDecryptedData + sliceOffset, sliceBlockCount * Detail::Aes128BlockSize, key, sliceIVs[sliceIndex]))
+						failedSliceCount++;
+				});
+			}
+
+			threadPool.Wait(sliceTaskGroup);
+			return (failedSliceCount == 0);
+		}
+
+		bool EncryptAes128Cbc(const u8* inDecryptedData, u8* outEncryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv)
+		{
+			assert(Align(inOutDataSize, Aes128Alignment) == inOutDataSize);
+			if (Align(inOutDataSize, Aes128Alignment) != inOutDataSize)
+				return false;
+
+			const auto roundKeys = Detail::ExpandAes128Key(key);
+			const size_t blockCount = (inOutDataSize / Detail::Aes128BlockSize);
+
+			if (Detail::CpuSupportsAesNi())
+				Detail::AesNi::EncryptCbc(inDecryptedData, outEncryptedData, blockCount, roundKeys, iv.data());
+			else
+				Detail::Scalar::EncryptCbc(inDecryptedData, outEncryptedData, blockCount, roundKeys, iv.data());
+			return true;
+		}
+
+		bool EncryptAes128CbcKeepingLastBlock(const u8* inDecryptedData, u8* inOutEncryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes& outIV)
+		{
+			if (inOutDataSize == 0 || Align(inOutDataSize, Aes128Alignment) != inOutDataSize)
+				return false;
+
+			const auto roundKeys = Detail::ExpandAes128Key(key);
+			const bool useAesNi = Detail::CpuSupportsAesNi();
+
+			// NOTE: Each previous ciphertext block is derived as C[i - 1] = Decrypt(C[i]) ^ P[i],
+			//		 which is exactly a single block CBC decryption of C[i] using P[i] as its IV
+			for (size_t blockIndex = (inOutDataSize / Detail::Aes128BlockSize); blockIndex-- > 0;)
+			{
+				const u8* currentCipherBlock = &inOutEncryptedData[blockIndex * Detail::Aes128BlockSize];
+				const u8* currentPlainBlock = &inDecryptedData[blockIndex * Detail::Aes128BlockSize];
+				u8* previousCipherBlock = (blockIndex > 0) ? &inOutEncryptedData[(blockIndex - 1) * Detail::Aes128BlockSize] : outIV.data();
+
+				if (useAesNi)
+					Detail::AesNi::DecryptCbc(currentCipherBlock, previousCipherBlock, 1, roundKeys, currentPlainBlock);
+				else
+					Detail::Scalar::DecryptCbc(currentCipherBlock, previousCipherBlock, 1, roundKeys, currentPlainBlock);
+			}
+
+			return true;
+		}
+
+		Aes128KeyBytes ParseAes128KeyHexByteString(std::string_view hexByteString)
+		{
+			constexpr size_t hexDigitsPerByte = 2;
+
+			char upperCaseHexChars[(Aes128KeySize * hexDigitsPerByte) + sizeof('\0')] = {};
+			size_t hexCharsWrittenSoFar = 0;
+
+			for (size_t charIndex = 0; charIndex < hexByteString.size(); charIndex++)
+			{
+				if (ASCII::IsWhiteSpace(hexByteString[charIndex]))
+					continue;
+
+				const char upperCaseChar = ASCII::ToUpperCase(hexByteString[charIndex]);
+				upperCaseHexChars[hexCharsWrittenSoFar++] = ((upperCaseChar >= '0' && upperCaseChar <= '9') || (upperCaseChar >= 'A' && upperCaseChar <= 'F')) ? upperCaseChar : '0';
+
+				if (hexCharsWrittenSoFar >= std::size(upperCaseHexChars))
+					break;
+			}
+
+			Aes128KeyBytes resultKeyBytes = {};
+			for (size_t byteIndex = 0; byteIndex < resultKeyBytes.size(); byteIndex++)
+			{
+				auto upperCaseHexCharToNibble = [](char c) -> u8 { return (c >= '0' && c <= '9') ? (c - '0') : (c >= 'A' && c <= 'F') ? (0xA + (c - 'A')) : 0x0; };
+
+				u8 combinedByte = 0x00;
+				combinedByte |= (upperCaseHexCharToNibble(upperCaseHexChars[(byteIndex * hexDigitsPerByte) + 0]) << 4);
+				combinedByte |= (upperCaseHexCharToNibble(upperCaseHexChars[(byteIndex * hexDigitsPerByte) + 1]) << 0);
+				resultKeyBytes[byteIndex] = combinedByte;
+			}
+			return resultKeyBytes;
+		}
+	}
+
+	namespace IO
+	{
+		ContentAddressedStore::ContentAddressedStore(std::string_view storeDirectory) : directory(storeDirectory)
+		{
+			CreateFileDirectory(directory);
+		}
+
+		bool ContentAddressedStore::WriteFile(std::string_view outputFilePath, const u8* fileContent, size_t fileSize)
+		{
+			if (outputFilePath.empty() || (fileContent == nullptr && fileSize != 0))
+				return false;
+
+			Hash::Hash128 contentHash;
+			{
+				Trace::ScopedEvent hashEvent("hash", fileSize, "xxh3_128");
+				contentHash = Hash::ComputeXXH128(fileContent, fileSize);
+			}
+
+			const std::string blobFilePath = GetBlobFilePath(contentHash);
+			bool blobAlreadyExisted = false;
+			{
+				auto& stripe = blobStripes[contentHash.High % BlobStripeCount];
+				std::scoped_lock lock(stripe.Mutex);
+
+				blobAlreadyExisted = (stripe.KnownBlobs.count(contentHash) != 0);
+				if (!blobAlreadyExisted)
+				{
+					// NOTE: Size checked so that a truncated blob left behind by a crashed run is replaced rather than linked
+					blobAlreadyExisted = (FileExists(blobFilePath) && GetFileSize(blobFilePath) == fileSize);
+					if (!blobAlreadyExisted && !WriteBlobFile(blobFilePath, fileContent, fileSize))
+						return WriteEntireFile(outputFilePath, fileContent, fileSize);
+
+					stripe.KnownBlobs.insert(contentHash);
+				}
+			}
+
+			// NOTE: Any previous output file has to be removed first for the link to be created, be it a plain file or an older link
+			RemoveFile(outputFilePath);
+			if (!CreateFileHardLink(outputFilePath, blobFilePath))
+				return WriteEntireFile(outputFilePath, fileContent, fileSize);
+
+			if (blobAlreadyExisted)
+			{
+				deduplicatedFileCount++;
+				deduplicatedByteCount += fileSize;
+			}
+			return true;
+		}
+
+		size_t ContentAddressedStore::GetDeduplicatedFileCount() const
+		{
+			return deduplicatedFileCount;
+		}
+
+		u64 ContentAddressedStore::GetDeduplicatedByteCount() const
+		{
+			return deduplicatedByteCount;
+		}
+
+		size_t ContentAddressedStore::GetWrittenBlobCount() const
+		{
+			return writtenBlobCount;
+		}
+
+		std::string ContentAddressedStore::GetBlobFilePath(const Hash::Hash128& hash) const
+		{
+			// NOTE: Fanned out into subdirectories by the first hash byte to keep the individual directories small
+			char hashHexChars[(sizeof(Hash::Hash128) * 2) + sizeof('\0')];
+			snprintf(hashHexChars, sizeof(hashHexChars), "%016llx%016llx", static_cast<unsigned long long>(hash.High), static_cast<unsigned long long>(hash.Low));
+
+			std::string blobFilePath;
+			blobFilePath.reserve(directory.size() + 4 + std::size(hashHexChars));
+			blobFilePath.append(directory).append("/").append(hashHexChars, 2).append("/").append(hashHexChars);
+			return blobFilePath;
+		}
+
+		bool ContentAddressedStore::WriteBlobFile(std::string_view blobFilePath, const u8* fileContent, size_t fileSize)
+		{
+			const std::string_view blobDirectory = blobFilePath.substr(0, blobFilePath.find_last_of('/'));
+			CreateFileDirectory(blobDirectory);
+
+			// NOTE: Written under a temporary name unique to this process and thread and then renamed
+			//		 so that neither a concurrently running process nor a later run can ever link a partially written blob
+			char temporarySuffix[48];
+			snprintf(temporarySuffix, sizeof(temporarySuffix), ".%u.%u.tmp", static_cast<u32>(::GetCurrentProcessId()), static_cast<u32>(::GetCurrentThreadId()));
+
+			std::string temporaryFilePath;
+			temporaryFilePath.reserve(blobFilePath.size() + std::size(temporarySuffix));
+			temporaryFilePath.append(blobFilePath).append(temporarySuffix);
+
+			{
+				Trace::ScopedEvent writeEvent("write", fileSize, "blob");
+				if (!WriteEntireFile(temporaryFilePath, fileContent, fileSize))
+				{
+					RemoveFile(temporaryFilePath);
+					return false;
+				}
+			}
+
+			if (!RenameFile(temporaryFilePath, blobFilePath))
+			{
+				// NOTE: Either another process has just stored the same blob or a previously truncated one is still in the way
+				if (!(FileExists(blobFilePath) && GetFileSize(blobFilePath) == fileSize))
+				{
+					RemoveFile(blobFilePath);
+					if (!RenameFile(temporaryFilePath, blobFilePath))
+					{
+						RemoveFile(temporaryFilePath);
+						return false;
+					}
+					writtenBlobCount++;
+					return true;
+				}
+
+				RemoveFile(temporaryFilePath);
+				return true;
+			}
+
+			writtenBlobCount++;
+			return true;
 		}
 	}
 }
@@ -1,5 +1,12 @@
 #pragma once
 #include "Types.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
 
 // NOTE: In case anyone is wondering... no, there is no particular reason for these names. 
 //		 I just like Peepo and it cheers me up after looking at code all day :WidePeepoHappy:
@@ -25,22 +32,32 @@ namespace PeepoHappy
 		constexpr bool CaseInsenitiveComparison(char a, char b) { return (ToLowerCase(a) == ToLowerCase(b)); }
 
 		constexpr bool Matches(std::string_view a, std::string_view b) { if (a.size() != b.size()) return false; for (auto i = 0; i < a.size(); i++) { if (!CaseSensitiveComparison(a[i], b[i])) return false; } return true; }
-		constexpr bool MatchesInsensitive(std::string_view a, std::string_view b) { if (a.size() != b.size()) return false; for (auto i = 0; i < a.size(); i++) { if (!CaseInsenitiveComparison(a[i], b[i])) return false; } return true; }
+		// NOTE: Lower cases and compares 16 characters at a time using SSE2
+		bool MatchesInsensitive(std::string_view a, std::string_view b);
 		constexpr bool StartsWith(std::string_view s, std::string_view prefix) { return (s.size() >= prefix.size() && Matches(s.substr(0, prefix.size()), prefix)); }
-		constexpr bool StartsWithInsensitive(std::string_view s, std::string_view prefix) { return (s.size() >= prefix.size() && MatchesInsensitive(s.substr(0, prefix.size()), prefix)); }
+		inline bool StartsWithInsensitive(std::string_view s, std::string_view prefix) { return (s.size() >= prefix.size() && MatchesInsensitive(s.substr(0, prefix.size()), prefix)); }
 		constexpr bool EndsWith(std::string_view s, std::string_view suffix) { return (s.size() >= suffix.size() && Matches(s.substr(s.size() - suffix.size()), suffix)); }
-		constexpr bool EndsWithInsensitive(std::string_view s, std::string_view suffix) { return (s.size() >= suffix.size() && MatchesInsensitive(s.substr(s.size() - suffix.size()), suffix)); }
+		inline bool EndsWithInsensitive(std::string_view s, std::string_view suffix) { return (s.size() >= suffix.size() && MatchesInsensitive(s.substr(s.size() - suffix.size()), suffix)); }
 
 		constexpr std::string_view StripPrefix(std::string_view s, std::string_view prefix) { return StartsWith(s, prefix) ? s.substr(prefix.size(), s.size() - prefix.size()) : s; }
-		constexpr std::string_view StripPrefixInsensitive(std::string_view s, std::string_view prefix) { return StartsWithInsensitive(s, prefix) ? s.substr(prefix.size(), s.size() - prefix.size()) : s; }
+		inline std::string_view StripPrefixInsensitive(std::string_view s, std::string_view prefix) { return StartsWithInsensitive(s, prefix) ? s.substr(prefix.size(), s.size() - prefix.size()) : s; }
 		constexpr std::string_view StripSuffix(std::string_view s, std::string_view suffix) { return EndsWith(s, suffix) ? s.substr(0, s.size() - suffix.size()) : s; }
-		constexpr std::string_view StripSuffixInsensitive(std::string_view s, std::string_view suffix) { return EndsWithInsensitive(s, suffix) ? s.substr(0, s.size() - suffix.size()) : s; }
+		inline std::string_view StripSuffixInsensitive(std::string_view s, std::string_view suffix) { return EndsWithInsensitive(s, suffix) ? s.substr(0, s.size() - suffix.size()) : s; }
 
-		constexpr std::string_view TrimLeft(std::string_view s) { auto f = s.find_first_not_of(WhiteSpaceCharacters); return (f == std::string_view::npos) ? s : s.substr(f); }
-		constexpr std::string_view TrimRight(std::string_view s) { auto l = s.find_last_not_of(WhiteSpaceCharacters); return (l == std::string_view::npos) ? s : s.substr(0, l + 1); }
+		// NOTE: Case insensitive glob match supporting '*' for any number of characters and '?' for exactly one character
+		bool MatchesGlobInsensitive(std::string_view s, std::string_view globPattern);
+
+		constexpr std::string_view TrimLeft(std::string_view s) { auto f = s.find_first_not_of(WhiteSpaceCharacters); return (f == std::string_view::npos) ? s.substr(s.size()) : s.substr(f); }
+		constexpr std::string_view TrimRight(std::string_view s) { auto l = s.find_last_not_of(WhiteSpaceCharacters); return (l == std::string_view::npos) ? s.substr(0, 0) : s.substr(0, l + 1); }
 		constexpr std::string_view Trim(std::string_view s) { return TrimRight(TrimLeft(s)); }
 	}
 
+	namespace JSON
+	{
+		// NOTE: Appends the value as a quoted JSON string literal, escaping quotes, backslashes and control characters
+		void AppendEscapedString(std::string& outString, std::string_view value);
+	}
+
 	// NOTE: Following the "UTF-8 Everywhere" guidelines
 	namespace UTF8
 	{
@@ -86,9 +103,358 @@ namespace PeepoHappy
 	namespace IO
 	{
 		void CreateFileDirectory(std::string_view directoryPath);
+
+		bool FileExists(std::string_view filePath);
+		bool DirectoryExists(std::string_view directoryPath);
+		u64 GetFileSize(std::string_view filePath);
+
+		// NOTE: In 100-nanosecond intervals since January 1, 1601 (UTC) as returned by the file system
+		u64 GetFileLastWriteTime(std::string_view filePath);
+
+		// NOTE: Non recursive, returns the full paths of all files directly inside the directory
+		std::vector<std::string> GetFilesInDirectory(std::string_view directoryPath);
 		
 		std::pair<std::unique_ptr<u8[]>, size_t> ReadEntireFile(std::string_view filePath);
 		bool WriteEntireFile(std::string_view filePath, const u8* fileContent, size_t fileSize);
+
+		bool RemoveFile(std::string_view filePath);
+		// NOTE: Fails instead of replacing the destination file if it already exists
+		bool RenameFile(std::string_view sourceFilePath, std::string_view destinationFilePath);
+		// NOTE: Both paths have to be located on the same volume
+		bool CreateFileHardLink(std::string_view linkFilePath, std::string_view existingFilePath);
+
+		// NOTE: Copy-on-write view of an entire file. Pages are only read in once they are first accessed
+		//		 and any writes stay private to the process so the file on disk is never modified
+		class MappedFile : NonCopyable
+		{
+		public:
+			MappedFile() = default;
+			MappedFile(MappedFile&& other);
+			MappedFile& operator=(MappedFile&& other);
+			~MappedFile();
+
+		public:
+			bool Open(std::string_view filePath);
+			void Close();
+
+			bool IsOpen() const;
+			u8* Data() const;
+			size_t Size() const;
+
+		private:
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+			u8* viewData = nullptr;
+			size_t viewSize = 0;
+		};
+
+		// NOTE: Creates a new file preallocated to its final size and maps it writable so its content can be produced in place.
+		//		 Closing the file without calling Commit() first deletes it again so no truncated or partially written files are left behind
+		class MappedOutputFile : NonCopyable
+		{
+		public:
+			MappedOutputFile() = default;
+			~MappedOutputFile();
+
+		public:
+			bool Create(std::string_view filePath, size_t fileSize);
+			bool Commit();
+			void Close();
+
+			u8* Data() const;
+			size_t Size() const;
+
+		private:
+			std::string path;
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+			u8* viewData = nullptr;
+			size_t viewSize = 0;
+			bool committed = false;
+		};
+		// NOTE: Sequentially written output file of a size not known up front which can also be read back and patched at any offset.
+		//		 Just like the MappedOutputFile it is deleted again when closed without calling Commit() first
+		class StreamOutputFile : NonCopyable
+		{
+		public:
+			StreamOutputFile() = default;
+			~StreamOutputFile();
+
+		public:
+			bool Create(std::string_view filePath);
+			// NOTE: Opens an existing file to be read and patched in place, which unlike a newly created file is never deleted when closed
+			bool OpenExisting(std::string_view filePath);
+			bool Commit();
+			void Close();
+
+			// NOTE: Appends to the end of the file
+			bool Write(const u8* data, size_t dataSize);
+			bool WriteAt(u64 fileOffset, const u8* data, size_t dataSize);
+			bool ReadAt(u64 fileOffset, u8* outData, size_t dataSize);
+
+			u64 Size() const;
+
+		private:
+			bool SeekTo(u64 fileOffset);
+
+		private:
+			std::string path;
+			void* fileHandle = nullptr;
+			u64 fileSize = 0;
+			bool committed = false;
+		};
+	}
+
+	namespace Memory
+	{
+		constexpr size_t CacheLineSize = 64;
+
+		class BufferPool;
+
+		struct PooledBufferDeleter
+		{
+			BufferPool* Pool = nullptr;
+			size_t ByteSize = 0;
+
+			void operator()(u8* buffer) const;
+		};
+
+		using PooledBuffer = std::unique_ptr<u8[], PooledBufferDeleter>;
+
+		// NOTE: Hands out uninitialized cache line aligned buffers. Requests of up to MaxSizeClassShift are rounded up to a power of two size class
+		//		 and recycled through per size class free lists once released, with a request also being served by a free buffer of a few size classes larger
+		//		 so that buffers left behind by a shift in the mix of sizes still get reused. Only the small size classes are carved out of larger slabs,
+		//		 the others are allocated individually so that the free buffers kept around can be capped at MaxRetainedFreeByteSize with any excess freed right away.
+		//		 All slabs are freed at once when the pool is destroyed so every buffer must have been released by then
+		class BufferPool : NonCopyable
+		{
+		public:
+			BufferPool() = default;
+			~BufferPool();
+
+		public:
+			PooledBuffer Allocate(size_t byteSize);
+			void Release(u8* buffer, size_t byteSize);
+
+		private:
+			static constexpr size_t MinSizeClassShift = 6;
+			static constexpr size_t MaxSizeClassShift = 20;
+			static constexpr size_t MaxSlabSizeClassShift = 16;
+			static constexpr size_t SlabSize = (4 * 1024 * 1024);
+			static constexpr size_t MaxSizeClassReuseSteps = 4;
+			static constexpr size_t MaxRetainedFreeByteSize = (32 * 1024 * 1024);
+
+			static size_t GetSizeClassIndex(size_t byteSize);
+			static size_t GetSizeClassSize(size_t sizeClassIndex);
+			static bool IsSlabSizeClass(size_t sizeClassIndex);
+
+		private:
+			std::mutex mutex;
+			std::vector<u8*> slabs;
+			u8* slabHead = nullptr;
+			size_t slabRemainingSize = 0;
+			// NOTE: Total size of all free buffers of the individually allocated size classes
+			size_t retainedFreeByteSize = 0;
+			std::array<std::vector<u8*>, (MaxSizeClassShift - MinSizeClassShift + 1)> freeLists;
+		};
+	}
+
+	namespace Threading
+	{
+		u32 GetHardwareThreadCount();
+
+		// NOTE: Tracks a subset of the tasks submitted to a ThreadPool so they can be waited on independently of all others
+		struct TaskGroup : NonCopyable
+		{
+			size_t PendingTaskCount = 0;
+		};
+
+		// NOTE: Fixed number of worker threads consuming tasks from a shared FIFO queue in submission order.
+		//		 WaitUntilIdle() must only ever be called from outside of the pool itself while Wait(TaskGroup&)
+		//		 runs queued tasks on the calling thread until the group has finished, so it is safe to call from within a task
+		class ThreadPool : NonCopyable
+		{
+		public:
+			explicit ThreadPool(u32 threadCount);
+			~ThreadPool();
+
+		public:
+			void Enqueue(std::function<void()> task);
+			void Enqueue(TaskGroup& group, std::function<void()> task);
+
+			void WaitUntilIdle();
+			void Wait(TaskGroup& group);
+
+			u32 GetThreadCount() const;
+
+		private:
+			struct QueuedTask
+			{
+				std::function<void()> Function;
+				TaskGroup* Group;
+			};
+
+			void WorkerThreadLoop();
+			void RunDequeuedTask(QueuedTask& task, std::unique_lock<std::mutex>& lock);
+
+		private:
+			std::vector<std::thread> workerThreads;
+			std::mutex queueMutex;
+			std::condition_variable taskAvailableCondition;
+			std::condition_variable taskFinishedCondition;
+			std::deque<QueuedTask> taskQueue;
+			size_t runningTaskCount = 0;
+			bool shutdownRequested = false;
+		};
+
+		// NOTE: Blocking multi producer multi consumer FIFO holding at most a fixed number of items.
+		//		 Once closed Push() fails immediately while Pop() keeps returning the remaining items until the queue is empty
+		template <typename T>
+		class BoundedQueue : NonCopyable
+		{
+		public:
+			explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+		public:
+			bool Push(T item)
+			{
+				std::unique_lock lock(mutex);
+				notFullCondition.wait(lock, [this] { return closed || items.size() < capacity; });
+				if (closed)
+					return false;
+
+				items.push_back(std::move(item));
+				notEmptyCondition.notify_one();
+				return true;
+			}
+
+			bool Pop(T& outItem)
+			{
+				std::unique_lock lock(mutex);
+				notEmptyCondition.wait(lock, [this] { return closed || !items.empty(); });
+				if (items.empty())
+					return false;
+
+				outItem = std::move(items.front());
+				items.pop_front();
+				notFullCondition.notify_one();
+				return true;
+			}
+
+			void Close()
+			{
+				std::scoped_lock lock(mutex);
+				closed = true;
+				notFullCondition.notify_all();
+				notEmptyCondition.notify_all();
+			}
+
+		private:
+			const size_t capacity;
+			std::mutex mutex;
+			std::condition_variable notFullCondition;
+			std::condition_variable notEmptyCondition;
+			std::deque<T> items;
+			bool closed = false;
+		};
+
+		// NOTE: Counting semaphore measured in bytes used to cap the amount of memory held by in-flight work.
+		//		 A single request larger than the entire budget is still granted once nothing else is in flight
+		class ByteBudget : NonCopyable
+		{
+		public:
+			explicit ByteBudget(size_t maxBytes);
+
+		public:
+			void Acquire(size_t byteSize);
+			void Release(size_t byteSize);
+
+			size_t GetMaxBytes() const;
+			size_t GetPeakBytes() const;
+
+		private:
+			const size_t maxBytes;
+			mutable std::mutex mutex;
+			std::condition_variable releasedCondition;
+			size_t inFlightBytes = 0;
+			size_t peakBytes = 0;
+		};
+	}
+
+	namespace Trace
+	{
+		struct Event
+		{
+			// NOTE: Both expected to be string literals, the detail being an optional sub category such as the compression method
+			const char* Stage;
+			const char* Detail;
+			std::string Label;
+			i64 StartTicks;
+			i64 EndTicks;
+			u64 ByteCount;
+		};
+
+		inline std::atomic<bool> GlobalIsEnabled = false;
+		inline bool IsEnabled() { return GlobalIsEnabled.load(std::memory_order_relaxed); }
+
+		// NOTE: Has to be called before any of the threads to be traced start doing work
+		void Enable();
+
+		i64 GetTimestampTicks();
+		void RecordEvent(Event&& event);
+
+		// NOTE: Costs a single relaxed load unless tracing has been enabled, in which case the completed scope is appended
+		//		 to an event list owned by the calling thread. The label has to outlive the scope
+		class ScopedEvent : NonCopyable
+		{
+		public:
+			ScopedEvent(const char* stage, u64 byteCount = 0, const char* detail = nullptr, std::string_view label = {})
+				: stage(stage), detail(detail), label(label), byteCount(byteCount), startTicks(IsEnabled() ? GetTimestampTicks() : 0)
+			{
+			}
+
+			~ScopedEvent()
+			{
+				if (startTicks != 0)
+					RecordEvent(Event { stage, detail, std::string(label), startTicks, GetTimestampTicks(), byteCount });
+			}
+
+			void SetByteCount(u64 value) { byteCount = value; }
+
+		private:
+			const char* stage;
+			const char* detail;
+			std::string_view label;
+			u64 byteCount;
+			i64 startTicks;
+		};
+
+		// NOTE: Must only be called once all traced threads have finished (or are idle)
+		bool WriteChromeTraceJson(std::string_view filePath);
+		// NOTE: Prints the event count, bytes, total busy time and wall clock span per stage (and detail) along with the resulting throughput
+		void PrintThroughputSummary();
+	}
+
+	namespace Hash
+	{
+		// NOTE: Plain scalar implementation of the non-cryptographic 64-bit xxHash (XXH64) producing the same values as the reference implementation
+		u64 ComputeXXH64(const u8* data, size_t dataSize, u64 seed = 0);
+
+		// NOTE: Unseeded 64-bit XXH3 using the default secret, producing the same values as the reference XXH3_64bits().
+		//		 Inputs longer than 240 bytes are processed 64 byte stripes at a time using either AVX2 or SSE2 depending on CPU support
+		u64 ComputeXXH3(const u8* data, size_t dataSize);
+
+		struct Hash128
+		{
+			u64 Low;
+			u64 High;
+
+			bool operator==(const Hash128& other) const { return (Low == other.Low && High == other.High); }
+			bool operator!=(const Hash128& other) const { return !(*this == other); }
+		};
+
+		// NOTE: Unseeded 128-bit XXH3 using the default secret, producing the same values as the reference XXH3_128bits() and sharing its long input kernels with ComputeXXH3()
+		Hash128 ComputeXXH128(const u8* data, size_t dataSize);
 	}
 
 	namespace Crypto
@@ -103,8 +469,63 @@ namespace PeepoHappy
 		constexpr size_t Align(size_t value, size_t alignment) { return (value + (alignment - 1)) & ~(alignment - 1); }
 
 		bool DecryptAes128Cbc(const u8* inEncryptedData, u8* outDecryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv);
+
+		// NOTE: Splits the data into block aligned slices decrypted concurrently on the thread pool, in-place decryption is supported
+		bool DecryptAes128Cbc(const u8* inEncryptedData, u8* outDecryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv, Threading::ThreadPool& threadPool);
 		bool EncryptAes128Cbc(const u8* inDecryptedData, u8* outEncryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes iv);
 
+		// NOTE: Encrypts the data while keeping its last (already encrypted) ciphertext block unchanged so everything following it still decrypts as is.
+		//		 The chain is walked backwards instead, with the IV being the final output rather than an input
+		bool EncryptAes128CbcKeepingLastBlock(const u8* inDecryptedData, u8* inOutEncryptedData, size_t inOutDataSize, Aes128KeyBytes key, Aes128IVBytes& outIV);
+
 		Aes128KeyBytes ParseAes128KeyHexByteString(std::string_view hexString);
 	}
+
+	namespace IO
+	{
+		// NOTE: Writes every distinct file content only once into the store directory as a blob named after its 128-bit XXH3 hash
+		//		 and hardlinks the output files to it, falling back to writing a plain copy if the link can't be created (such as across volumes).
+		//		 Blobs written by previous runs are reused as well so the same store can be shared by any number of output directories.
+		//		 All hardlinked output files share the same data on disk, modifying one of them in place modifies all others too
+		class ContentAddressedStore : NonCopyable
+		{
+		public:
+			explicit ContentAddressedStore(std::string_view storeDirectory);
+			~ContentAddressedStore() = default;
+
+		public:
+			bool WriteFile(std::string_view outputFilePath, const u8* fileContent, size_t fileSize);
+
+			// NOTE: Output files linked to an already existing blob instead of having their content written again
+			size_t GetDeduplicatedFileCount() const;
+			u64 GetDeduplicatedByteCount() const;
+			size_t GetWrittenBlobCount() const;
+
+		private:
+			std::string GetBlobFilePath(const Hash::Hash128& hash) const;
+			bool WriteBlobFile(std::string_view blobFilePath, const u8* fileContent, size_t fileSize);
+
+		private:
+			struct Hash128Hasher
+			{
+				size_t operator()(const Hash::Hash128& hash) const { return static_cast<size_t>(hash.Low); }
+			};
+
+			// NOTE: Only writes of blobs falling into the same stripe are serialized, writing and linking unrelated content stays concurrent
+			struct BlobStripe
+			{
+				std::mutex Mutex;
+				std::unordered_set<Hash::Hash128, Hash128Hasher> KnownBlobs;
+			};
+
+			static constexpr size_t BlobStripeCount = 64;
+
+			std::string directory;
+			std::array<BlobStripe, BlobStripeCount> blobStripes;
+
+			std::atomic<size_t> deduplicatedFileCount = 0;
+			std::atomic<u64> deduplicatedByteCount = 0;
+			std::atomic<size_t> writtenBlobCount = 0;
+		};
+	}
 }